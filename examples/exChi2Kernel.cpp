@@ -0,0 +1,106 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+#include <LatAnalyze/Physics/CorrelatorFitter.hpp>
+#include <LatAnalyze/Statistics/XYStatData.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NPOINT 4000
+#define NEVAL      200
+
+typedef chrono::high_resolution_clock Clock;
+
+// "minimizer" only evaluating the chi^2 function at the initial point
+class Chi2Timer: public Minimizer
+{
+public:
+    virtual bool supportLimits(void) const
+    {
+        return false;
+    }
+    virtual const DVec & operator()(const DoubleFunction &chi2)
+    {
+        DVec &x = getState();
+
+        auto start = Clock::now();
+
+        for (Index i = 0; i < NEVAL; ++i)
+        {
+            value += chi2(x);
+        }
+        time = chrono::duration<double, micro>(Clock::now() - start).count()
+               /NEVAL;
+
+        return x;
+    }
+public:
+    double value{0.}, time{0.};
+};
+
+static void bench(const string name, XYStatData &data,
+                  const DoubleModel &model, const DVec &init, Chi2Timer &timer)
+{
+    timer.value = 0.;
+    timer.setInit(init);
+    data.fit(timer, init, model);
+    cout << name << ": " << timer.time << " us/chi^2 (sum= " << timer.value
+         << ")" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    Index nPoint = DEF_NPOINT;
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<#point>]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nPoint = strTo<Index>(argv[1]);
+    }
+
+    // two-state correlator data
+    XYStatData  data;
+    DVec        init(4);
+    DoubleModel model = CorrelatorModels::makeExpModel(2), scalar = model;
+    DoubleModel compiled = compile("return p_1*exp(-p_0*x_0)"
+                                   " + p_3*exp(-p_2*x_0);", 1, 4);
+    Chi2Timer   timer;
+
+    init << 0.3, 1.2, 0.8, 0.4;
+    data.addXDim(nPoint);
+    data.addYDim();
+    for (Index k = 0; k < nPoint; ++k)
+    {
+        double t = 64.*k/nPoint;
+
+        data.x(k, 0) = t;
+        data.y(k, 0) = model(&t, init.data())*(1. + 0.01*sin(k));
+    }
+    data.setYError(0, DVec::Constant(nPoint, 1.0e-3));
+    data.assumeXExact(true, 0);
+
+    // the scalar model has no batch function and is evaluated point by point
+    scalar.setBatchFunction(nullptr);
+    cout << "-- " << nPoint << " points, " << NEVAL << " chi^2 evaluations"
+         << endl;
+    bench("point by point", data, scalar, init, timer);
+
+    double scalarTime = timer.time, scalarValue = timer.value;
+
+    bench("batched       ", data, model, init, timer);
+    cout << "speedup       : " << scalarTime/timer.time << endl;
+    if (fabs(scalarValue - timer.value) > 1.0e-10*fabs(scalarValue))
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+    bench("compiled      ", data, compiled, init, timer);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Statistics/MatSample.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NT      96
+#define DEF_NSAMPLE 2000
+#define NREPEAT     10
+
+typedef chrono::high_resolution_clock Clock;
+
+// previous estimator, reduction of one tensor product per sample
+static DMat tensProdVarianceMatrix(const DMatSample &s)
+{
+    const Index n = s.size();
+    auto        seg = s.segment(1, n);
+    DMat        s1, prs;
+
+    s1  = seg.redux(&ReducOp::sum<DMat>);
+    prs = seg.binaryExpr(seg, &ReducOp::tensProd<DMat>)
+             .redux(&ReducOp::sum<DMat>);
+
+    return (prs - ReducOp::tensProd(s1, s1)/static_cast<double>(n))
+           /static_cast<double>(n - 1);
+}
+
+int main(int argc, char *argv[])
+{
+    Index nt = DEF_NT, nSample = DEF_NSAMPLE;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<nt> [<#sample>]]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nt = strTo<Index>(argv[1]);
+    }
+    if (argc > 2)
+    {
+        nSample = strTo<Index>(argv[2]);
+    }
+
+    // correlated exponential "correlator" sample
+    mt19937               gen(42);
+    normal_distribution<> dis;
+    DMatSample            corr(nSample, nt, 1);
+
+    FOR_STAT_ARRAY(corr, s)
+    {
+        double z = dis(gen);
+
+        for (Index t = 0; t < nt; ++t)
+        {
+            corr[s](t) = exp(-0.2*t)*(1. + 0.05*z + 0.01*dis(gen));
+        }
+    }
+
+    DMat oldVar, newVar, corrMat;
+    auto start = Clock::now();
+
+    for (Index i = 0; i < NREPEAT; ++i)
+    {
+        oldVar = tensProdVarianceMatrix(corr);
+    }
+
+    double oldTime = chrono::duration<double, milli>(Clock::now() - start)
+                     .count()/NREPEAT;
+
+    start = Clock::now();
+    for (Index i = 0; i < NREPEAT; ++i)
+    {
+        newVar = corr.varianceMatrix();
+    }
+
+    double newTime = chrono::duration<double, milli>(Clock::now() - start)
+                     .count()/NREPEAT;
+
+    start = Clock::now();
+    for (Index i = 0; i < NREPEAT; ++i)
+    {
+        corrMat = corr.correlationMatrix();
+    }
+
+    double corrTime = chrono::duration<double, milli>(Clock::now() - start)
+                      .count()/NREPEAT;
+    double relDiff  = (oldVar - newVar).cwiseAbs().maxCoeff()
+                      /newVar.cwiseAbs().maxCoeff();
+
+    cout << "-- nt= " << nt << ", " << nSample << " samples" << endl;
+    cout << "tensor product reduction: " << oldTime << " ms" << endl;
+    cout << "rank-k update           : " << newTime << " ms" << endl;
+    cout << "correlation matrix      : " << corrTime << " ms" << endl;
+    cout << "speedup                 : " << oldTime/newTime << endl;
+    cout << "max. relative difference: " << relDiff << endl;
+
+    return (relDiff < 1.0e-10) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,115 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/Function.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NEVAL 200000
+#define DEF_DEPTH 32
+
+typedef chrono::high_resolution_clock Clock;
+
+// composition through nested closures, each level calls the previous one
+static DoubleFunction nestedAdd(const DoubleFunction &f,
+                                const DoubleFunction &g, const double c)
+{
+    return DoubleFunction([f, g, c](const double *arg)
+                          {return f(arg) + c*g(arg);}, f.getNArg());
+}
+
+static double timeEval(const DoubleFunction &f, const Index nEval,
+                       double &sum)
+{
+    double arg[2] = {0., 0.5};
+
+    sum = 0.;
+
+    auto start = Clock::now();
+
+    for (Index i = 0; i < nEval; ++i)
+    {
+        arg[0] = static_cast<double>(i % 64)/8.;
+        sum   += f(arg);
+    }
+
+    return chrono::duration<double, nano>(Clock::now() - start).count()/nEval;
+}
+
+int main(int argc, char* argv[])
+{
+    Index nEval = DEF_NEVAL, depth = DEF_DEPTH;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<#evaluation> [<depth>]]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nEval = strTo<Index>(argv[1]);
+    }
+    if (argc > 2)
+    {
+        depth = strTo<Index>(argv[2]);
+    }
+
+    // sum of depth exponentials, built term by term as one would do when
+    // assembling a multi-state model, then scaled and with the second
+    // argument bound
+    DoubleFunction e([](const double *x){return exp(-x[1]*x[0]);}, 2);
+    DoubleFunction nested = e, graph = e;
+
+    for (Index k = 1; k < depth; ++k)
+    {
+        const double c = 1./(k + 1);
+
+        nested = nestedAdd(nested, e, c);
+        graph  = graph + c*e;
+    }
+    nested = DoubleFunction([nested](const double *arg)
+                            {return 2.*nested(arg) - 1.;}, 2);
+    graph  = 2.*graph - 1.;
+
+    DoubleFunction nestedBind = nested.bind(1, 0.5);
+    DoubleFunction graphBind  = graph.bind(1, 0.5);
+    double         nestedSum, graphSum, nestedBindSum = 0., graphBindSum = 0.;
+    double         nestedNs  = timeEval(nested, nEval, nestedSum);
+    double         graphNs   = timeEval(graph, nEval, graphSum);
+    auto           start     = Clock::now();
+
+    for (Index i = 0; i < nEval; ++i)
+    {
+        nestedBindSum += nestedBind(static_cast<double>(i % 64)/8.);
+    }
+
+    double nestedBindNs = chrono::duration<double, nano>(Clock::now() - start)
+                          .count()/nEval;
+
+    start = Clock::now();
+    for (Index i = 0; i < nEval; ++i)
+    {
+        graphBindSum += graphBind(static_cast<double>(i % 64)/8.);
+    }
+
+    double graphBindNs = chrono::duration<double, nano>(Clock::now() - start)
+                         .count()/nEval;
+
+    cout << "-- " << nEval << " evaluations, composition depth " << depth
+         << endl;
+    cout << "nested closures : " << nestedNs << " ns/eval, bound "
+         << nestedBindNs << " ns/eval (sum= " << nestedSum << ")" << endl;
+    cout << "flattened graph : " << graphNs << " ns/eval, bound "
+         << graphBindNs << " ns/eval (sum= " << graphSum << ")" << endl;
+    cout << "speedup         : " << nestedNs/graphNs << ", bound "
+         << nestedBindNs/graphBindNs << endl;
+    if ((fabs(nestedSum - graphSum) > 1.0e-10*fabs(nestedSum))
+        or (fabs(nestedBindSum - graphBindSum) > 1.0e-10*fabs(nestedBindSum)))
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NEVAL 1000000
+
+typedef chrono::high_resolution_clock Clock;
+
+int main(int argc, char* argv[])
+{
+    // two-state correlators sharing their exponentials
+    vector<string> code = {
+        "return p_2*exp(-p_0*x_0) + p_3*exp(-p_1*x_0);",
+        "return p_4*exp(-p_0*x_0) + p_5*exp(-p_1*x_0);",
+        "return sqrt(p_2*p_4)*exp(-p_0*x_0) + sqrt(p_3*p_5)*exp(-p_1*x_0);"
+    };
+    Index nEval = DEF_NEVAL;
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<#evaluation>]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nEval = strTo<Index>(argv[1]);
+    }
+
+    FusedDoubleModel    fused(code, 1, 6);
+    vector<DoubleModel> model;
+    DVec                par(6), res(fused.getNOutput());
+    double              x, sepRes = 0., fusedRes = 0.;
+
+    cout << "-- fused program:" << endl << fused.getCode() << endl;
+    for (auto &c: code)
+    {
+        model.push_back(compile(c, 1, 6));
+    }
+    par << 0.3, 0.8, 1.0, 0.5, 2.0, 0.7;
+
+    // separate models
+    auto start = Clock::now();
+
+    for (Index i = 0; i < nEval; ++i)
+    {
+        x = static_cast<double>(i % 64);
+        for (auto &m: model)
+        {
+            sepRes += m(&x, par.data());
+        }
+    }
+
+    auto   time  = Clock::now() - start;
+    double sepNs = chrono::duration<double, nano>(time).count()/nEval;
+
+    // fused program
+    start = Clock::now();
+    for (Index i = 0; i < nEval; ++i)
+    {
+        x = static_cast<double>(i % 64);
+        fused(res.data(), &x, par.data());
+        fusedRes += res.sum();
+    }
+    time = Clock::now() - start;
+
+    double fusedNs = chrono::duration<double, nano>(time).count()/nEval;
+
+    cout << "-- " << nEval << " evaluations of " << code.size() << " models"
+         << endl;
+    cout << "separate: " << sepNs << " ns/point (sum= " << sepRes << ")"
+         << endl;
+    cout << "fused   : " << fusedNs << " ns/point (sum= " << fusedRes << ")"
+         << endl;
+    cout << "speedup : " << sepNs/fusedNs << endl;
+    if (fabs(sepRes - fusedRes) > 1.0e-10*fabs(sepRes))
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
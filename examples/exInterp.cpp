@@ -28,4 +28,16 @@ int main(void)
         double expected = (x > 0.5) ? 1.0 : ((x <= -0.5) ? 1.0 : 0.0);
         std::cout << " ( " << expected << " expected)" << std::endl;
     }
+    std::cout << std::endl;
+
+    tab = Latan::TabFunction(xs, ys, Latan::InterpType::CUBIC);
+
+    std::cout << "Interpolating naive y = x^2 data using natural cubic ";
+    std::cout << "spline interpolation..." << std::endl;
+    for (double x = -1.0; x < 1.0; x += 0.1) {
+        double y = tab(&x);
+        std::cout << "y @ " << x << " = " << y;
+        double expected = 1.5*x*x - 0.5*x*x*std::fabs(x);
+        std::cout << " ( " << expected << " expected)" << std::endl;
+    }
 }
@@ -0,0 +1,123 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Core/MathInterpreter.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NEVAL 1000000
+
+typedef chrono::high_resolution_clock Clock;
+
+// reference execution through the virtual Instruction objects
+static double legacyRun(const MathInterpreter &interpreter,
+                        RunContext &context)
+{
+    double res;
+
+    context.setInsIndex(0);
+    while (static_cast<Index>(context.getInsIndex())
+           != interpreter.getNInstruction())
+    {
+        (*interpreter[context.getInsIndex()])(context);
+    }
+    res = context.stack().top();
+    context.stack().pop();
+
+    return res;
+}
+
+int main(int argc, char* argv[])
+{
+    string source = "return p_1*exp(-p_0*x_0) + p_3*exp(-p_2*x_0);";
+    Index  nEval  = DEF_NEVAL;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<program> [<#evaluation>]]" << endl;
+        cerr << "(program variables: x_0, p_0, ..., p_3)" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        source = argv[1];
+    }
+    if (argc > 2)
+    {
+        nEval = strTo<Index>(argv[2]);
+    }
+
+    MathInterpreter interpreter(source);
+    RunContext      context;
+    unsigned int    x;
+    double          legacyRes = 0., vmRes = 0., batchRes = 0.;
+    vector<double>  xBatch(nEval), resBatch(nEval);
+
+    x = context.addVariable("x_0");
+    for (unsigned int j = 0; j < 4; ++j)
+    {
+        context.addVariable("p_" + strFrom(j), 0.1*(j + 1));
+    }
+    interpreter.compile(context);
+    cout << "-- Program (" << interpreter.getNInstruction()
+         << " instructions, stack depth "
+         << interpreter.getByteCode().getMaxStackDepth() << "):" << endl;
+    cout << interpreter << endl;
+
+    // legacy virtual dispatch
+    auto start = Clock::now();
+
+    for (Index i = 0; i < nEval; ++i)
+    {
+        context.setVariable(x, static_cast<double>(i % 64));
+        legacyRes += legacyRun(interpreter, context);
+    }
+
+    auto   legacyTime = Clock::now() - start;
+    double legacyNs   = chrono::duration<double, nano>(legacyTime).count()
+                        /nEval;
+
+    // byte code virtual machine
+    start = Clock::now();
+    for (Index i = 0; i < nEval; ++i)
+    {
+        context.setVariable(x, static_cast<double>(i % 64));
+        vmRes += interpreter.evaluate(context);
+    }
+
+    auto   vmTime = Clock::now() - start;
+    double vmNs   = chrono::duration<double, nano>(vmTime).count()/nEval;
+
+    // batched byte code virtual machine
+    for (Index i = 0; i < nEval; ++i)
+    {
+        xBatch[i] = static_cast<double>(i % 64);
+    }
+    start = Clock::now();
+    interpreter.evaluate(resBatch.data(), context, nEval, {x}, xBatch.data());
+
+    auto   batchTime = Clock::now() - start;
+    double batchNs   = chrono::duration<double, nano>(batchTime).count()/nEval;
+
+    for (Index i = 0; i < nEval; ++i)
+    {
+        batchRes += resBatch[i];
+    }
+    cout << "-- " << nEval << " evaluations" << endl;
+    cout << "instruction objects: " << legacyNs << " ns/eval (sum= "
+         << legacyRes << ")" << endl;
+    cout << "byte code VM       : " << vmNs << " ns/eval (sum= "
+         << vmRes << ")" << endl;
+    cout << "batched VM         : " << batchNs << " ns/eval (sum= "
+         << batchRes << ")" << endl;
+    cout << "speedup            : " << legacyNs/vmNs << " (VM), "
+         << legacyNs/batchNs << " (batched VM)" << endl;
+    if ((legacyRes != vmRes) or (legacyRes != batchRes))
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Core/MathInterpreter.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NEVAL 1000000
+
+typedef chrono::high_resolution_clock Clock;
+
+struct Timing
+{
+    double ns, batchNs, sum, batchSum;
+};
+
+// time the scalar and batched virtual machines on the program source, the
+// functions gexp and gcosh are user-registered copies of exp and cosh
+// executed through the generic function call path
+static Timing bench(const string &source, const Index nEval)
+{
+    DoubleFunction  gexp([](const double *x){return exp(x[0]);}, 1);
+    DoubleFunction  gcosh([](const double *x){return cosh(x[0]);}, 1);
+    MathInterpreter interpreter(source);
+    RunContext      context;
+    unsigned int    x;
+    vector<double>  xBatch(nEval), resBatch(nEval);
+    Timing          t = {0., 0., 0., 0.};
+
+    x = context.addVariable("x_0");
+    for (unsigned int j = 0; j < 4; ++j)
+    {
+        context.addVariable("p_" + strFrom(j), 0.1*(j + 1));
+    }
+    context.addFunction("gexp", &gexp);
+    context.addFunction("gcosh", &gcosh);
+    interpreter.compile(context);
+    cout << "-- Program:" << endl << interpreter << endl;
+
+    auto start = Clock::now();
+
+    for (Index i = 0; i < nEval; ++i)
+    {
+        context.setVariable(x, static_cast<double>(i % 64));
+        t.sum += interpreter.evaluate(context);
+    }
+    t.ns = chrono::duration<double, nano>(Clock::now() - start).count()/nEval;
+    for (Index i = 0; i < nEval; ++i)
+    {
+        xBatch[i] = static_cast<double>(i % 64);
+    }
+    start = Clock::now();
+    interpreter.evaluate(resBatch.data(), context, nEval, {x}, xBatch.data());
+    t.batchNs = chrono::duration<double, nano>(Clock::now() - start).count()
+                /nEval;
+    for (Index i = 0; i < nEval; ++i)
+    {
+        t.batchSum += resBatch[i];
+    }
+
+    return t;
+}
+
+int main(int argc, char* argv[])
+{
+    // two-state correlator with periodic and exponential terms
+    string model = "return p_1*cosh(-p_0*(x_0 - 32)) + p_3*exp(-p_2*x_0)"
+                   " + p_3*cosh(-p_2*(x_0 - 32));";
+    Index  nEval = DEF_NEVAL;
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<#evaluation>]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nEval = strTo<Index>(argv[1]);
+    }
+
+    string generic = model;
+
+    for (const string f: {"cosh", "exp"})
+    {
+        for (size_t p = generic.find(f + "("); p != string::npos;
+             p = generic.find(f + "(", p + f.size() + 2))
+        {
+            generic.insert(p, "g");
+        }
+    }
+
+    Timing tGen = bench(generic, nEval), tInt = bench(model, nEval);
+
+    cout << "-- " << nEval << " evaluations" << endl;
+    cout << "generic calls : " << tGen.ns << " ns/eval, batched "
+         << tGen.batchNs << " ns/eval (sum= " << tGen.sum << ")" << endl;
+    cout << "intrinsics    : " << tInt.ns << " ns/eval, batched "
+         << tInt.batchNs << " ns/eval (sum= " << tInt.sum << ")" << endl;
+    cout << "speedup       : " << tGen.ns/tInt.ns << " (VM), "
+         << tGen.batchNs/tInt.batchNs << " (batched VM)" << endl;
+    if ((tGen.sum != tInt.sum) or (tGen.batchSum != tInt.batchSum))
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
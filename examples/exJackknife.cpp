@@ -0,0 +1,92 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Statistics/Dataset.hpp>
+#include <LatAnalyze/Statistics/MatSample.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NDATA  1003
+#define BLOCK_SIZE 10
+
+int main(int argc, char *argv[])
+{
+    Index nData = DEF_NDATA;
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<#data>]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nData = strTo<Index>(argv[1]);
+    }
+
+    mt19937               gen(42);
+    normal_distribution<> dis;
+    Dataset<double>       data(nData);
+
+    for (Index i = 0; i < nData; ++i)
+    {
+        data[i] = 1. + 0.1*dis(gen);
+    }
+
+    // the jackknife variance of the mean is the variance of the data divided
+    // by the number of data
+    DSample s = data.jackknifeMean();
+    double  jackVar = s.variance(), var = data.variance()/nData;
+    double  diff = fabs(jackVar - var)/var;
+
+    // with blocks, the same holds for the block means, the configurations
+    // which do not fill a block are dropped
+    const Index     nBlock = nData/BLOCK_SIZE;
+    Dataset<double> blockMean(nBlock);
+    DSample         sb = data.jackknifeMean(BLOCK_SIZE);
+
+    for (Index k = 0; k < nBlock; ++k)
+    {
+        blockMean[k] = data.mean(k*BLOCK_SIZE, BLOCK_SIZE);
+    }
+
+    double blockJackVar = sb.variance(), blockVar = blockMean.variance()/nBlock;
+    double blockDiff    = fabs(blockJackVar - blockVar)/blockVar;
+    double centralDiff  = fabs(sb[central] - blockMean.mean());
+
+    cout << "-- " << nData << " data" << endl;
+    cout << "jackknife variance       : " << jackVar << endl;
+    cout << "data variance/n          : " << var << endl;
+    cout << "relative difference      : " << diff << endl;
+    cout << "-- blocks of " << BLOCK_SIZE << " data" << endl;
+    cout << "jackknife variance       : " << blockJackVar << endl;
+    cout << "block mean variance/n    : " << blockVar << endl;
+    cout << "relative difference      : " << blockDiff << endl;
+    cout << "central value difference : " << centralDiff << endl;
+
+    // the scheme is kept by copies, matrix sample operators and expressions,
+    // a raw Eigen expression on a sample needs an explicit scheme
+    DSample    s2 = 2.*s - 1.;
+    DMatSample m(s.size(), 2, 1), m2, m3;
+    bool       isKept;
+
+    FOR_STAT_ARRAY(s, i)
+    {
+        m[i] << s[i], s[i]*s[i];
+    }
+    m.setResampling(Resampling::jackknife);
+    m2     = m*3.;
+    m3     = (m.expr() - m2)/2.;
+    isKept = (s2.getResampling() == Resampling::bootstrap);
+    s2.setResampling(s.getResampling());
+    isKept = isKept and (DSample(s).getResampling() == Resampling::jackknife)
+             and (m2.getResampling() == Resampling::jackknife)
+             and (m3.getResampling() == Resampling::jackknife)
+             and (fabs(s.covariance(s2) - 2.*jackVar) < 1.0e-6*jackVar);
+    cout << "scheme kept by operations: " << (isKept ? "yes" : "no") << endl;
+
+    // the sum of squares estimator loses digits on the small spread of the
+    // jackknife samples, a wrong normalisation would be off by a factor ~n
+    return ((diff < 1.0e-6) and (blockDiff < 1.0e-6)
+            and (centralDiff < 1.0e-12) and isKept)
+           ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Statistics/MatSample.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_SIZE    8
+#define DEF_NSAMPLE 2000
+#define NREPEAT     20
+
+typedef chrono::high_resolution_clock Clock;
+
+static void randomSample(DMatSample &s, const Index nRow, const Index nCol,
+                         mt19937 &gen)
+{
+    normal_distribution<> dis;
+
+    FOR_STAT_ARRAY(s, i)
+    {
+        s[i].resize(nRow, nCol);
+        FOR_MAT(s[i], r, c)
+        {
+            s[i](r, c) = dis(gen);
+        }
+    }
+}
+
+template <typename F>
+static double time(const F &f)
+{
+    auto start = Clock::now();
+
+    for (Index i = 0; i < NREPEAT; ++i)
+    {
+        f();
+    }
+
+    return chrono::duration<double, milli>(Clock::now() - start).count()
+           /NREPEAT;
+}
+
+static double maxDiff(const DMatSample &a, const DMatSample &b)
+{
+    double d = 0.;
+
+    FOR_STAT_ARRAY(a, s)
+    {
+        d = max(d, (a[s] - b[s]).cwiseAbs().maxCoeff());
+    }
+
+    return d;
+}
+
+int main(int argc, char *argv[])
+{
+    Index n = DEF_SIZE, nSample = DEF_NSAMPLE;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<matrix size> [<#sample>]]"
+             << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        n = strTo<Index>(argv[1]);
+    }
+    if (argc > 2)
+    {
+        nSample = strTo<Index>(argv[2]);
+    }
+
+    mt19937    gen(42);
+    DMatSample a(nSample), b(nSample), c(nSample), u(nSample), v(nSample),
+               w(nSample), oldRes, newRes;
+    DSample    z(nSample);
+    double     d = 1.7, diff, oldTime, newTime;
+
+    randomSample(a, n, n, gen);
+    randomSample(b, n, n, gen);
+    randomSample(c, n, n, gen);
+    randomSample(u, n*n, 1, gen);
+    randomSample(v, n*n, 1, gen);
+    randomSample(w, n*n, 1, gen);
+    FOR_STAT_ARRAY(z, s)
+    {
+        z[s] = 1. + 0.1*s/nSample;
+    }
+    cout << "-- " << n << "x" << n << " matrices, " << nSample << " samples"
+         << endl;
+
+    // matrix product and linear combination
+    oldTime = time([&](void){oldRes = DMatSample(a*b - c)/d;});
+    newTime = time([&](void){newRes = (a.expr()*b - c)/d;});
+    diff    = maxDiff(oldRes, newRes);
+    cout << "(a*b - c)/d        : " << oldTime << " ms -> " << newTime
+         << " ms (speedup " << oldTime/newTime << ", diff= " << diff << ")"
+         << endl;
+    if (diff > 1.0e-12)
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // purely element-wise expression on vectors
+    oldTime = time([&](void){oldRes = DMatSample(u + v*2. - w)/d;});
+    newTime = time([&](void){newRes = (u.expr() + v.expr()*2. - w)/d;});
+    diff    = maxDiff(oldRes, newRes);
+    cout << "(u + 2*v - w)/d    : " << oldTime << " ms -> " << newTime
+         << " ms (speedup " << oldTime/newTime << ", diff= " << diff << ")"
+         << endl;
+    if (diff > 1.0e-12)
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // scalar sample operand, sample by sample loop without the fused layer
+    oldTime = time([&](void)
+    {
+        oldRes.resize(nSample);
+        FOR_STAT_ARRAY(oldRes, s)
+        {
+            oldRes[s] = (u[s] - w[s])/z[s];
+        }
+    });
+    newTime = time([&](void){newRes = (u.expr() - w)/z;});
+    diff    = maxDiff(oldRes, newRes);
+    cout << "(u - w)/z (sample) : " << oldTime << " ms -> " << newTime
+         << " ms (speedup " << oldTime/newTime << ", diff= " << diff << ")"
+         << endl;
+
+    return (diff < 1.0e-12) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
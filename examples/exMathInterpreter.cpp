@@ -30,6 +30,11 @@ int main(int argc, char* argv[])
     {
         cout << "<null>" << endl << endl;
     }
+    if (interpreter.getOptimizedAST())
+    {
+        cout << "-- Optimized Abstract Syntax Tree:" << endl;
+        cout << *interpreter.getOptimizedAST() << endl;
+    }
     cout << "-- Program:" << endl << interpreter << endl;
     cout << "-- Variable table:" << endl;
     for (auto &v: context.getVariableTable())
@@ -0,0 +1,73 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/MemoFunction.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define NTERM  200000
+#define NPOINT 100
+#define NPASS  10
+
+typedef chrono::high_resolution_clock Clock;
+
+int main(void)
+{
+    // slowly converging series, standing for an integral or a root
+    DoubleFunction f([](const double *x)
+    {
+        double s = 0.;
+
+        for (Index n = 1; n <= NTERM; ++n)
+        {
+            s += 1./(n*n + x[0]*x[0]);
+        }
+
+        return s;
+    }, 1);
+    MemoFunction   memo(f, NPOINT);
+    DoubleFunction g = memo.makeFunction();
+    double         fSum = 0., gSum = 0.;
+
+    // several passes on the same points, as repeated plots or fits do
+    auto start = Clock::now();
+
+    for (Index p = 0; p < NPASS; ++p)
+    for (Index i = 0; i < NPOINT; ++i)
+    {
+        fSum += f(0.1*i);
+    }
+
+    double fTime = chrono::duration<double, milli>(Clock::now() - start)
+                   .count();
+
+    start = Clock::now();
+    for (Index p = 0; p < NPASS; ++p)
+    for (Index i = 0; i < NPOINT; ++i)
+    {
+        gSum += g(0.1*i);
+    }
+
+    double gTime = chrono::duration<double, milli>(Clock::now() - start)
+                   .count();
+
+    cout << "-- " << NPASS << " passes on " << NPOINT << " points" << endl;
+    cout << "direct  : " << fTime << " ms (sum= " << fSum << ")" << endl;
+    cout << "memoized: " << gTime << " ms (sum= " << gSum << ")" << endl;
+    cout << "cache   : " << memo.getSize() << "/" << memo.getCapacity()
+         << " entries, " << memo.getNHit() << " hits, " << memo.getNMiss()
+         << " misses, " << memo.getNEviction() << " evictions (hit rate "
+         << memo.getHitRate() << ")" << endl;
+
+    // a too small cache evicts the entries before they are reused
+    memo.clear();
+    memo.resetStatistics();
+    memo.setCapacity(NPOINT/2);
+    for (Index p = 0; p < NPASS; ++p)
+    for (Index i = 0; i < NPOINT; ++i)
+    {
+        g(0.1*i);
+    }
+    cout << "small lru cache: hit rate " << memo.getHitRate() << endl;
+
+    return (fSum == gSum) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,48 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NEVAL 100000
+
+int main(int argc, char* argv[])
+{
+    string source = "a = exp(-p_0*x_0); return p_1*a"
+                    " + p_2*cosh(p_3*(x_0 - 16)) + atan2(a, 2);";
+    Index  nEval  = DEF_NEVAL;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<program> [<#evaluation>]]" << endl;
+        cerr << "(program variables: x_0, p_0, ..., p_3)" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        source = argv[1];
+    }
+    if (argc > 2)
+    {
+        nEval = strTo<Index>(argv[2]);
+    }
+
+    CompiledDoubleModel model(source, 1, 4);
+    DVec                par(4);
+    double              x, sum = 0.;
+
+    par << 0.3, 1.0, 0.5, 0.2;
+    model.setProfiling();
+    for (Index i = 0; i < nEval; ++i)
+    {
+        x    = static_cast<double>(i % 32);
+        sum += model(&x, par.data());
+    }
+    model.setProfiling(false);
+    cout << "-- profile of " << nEval << " evaluations (sum= " << sum << ")"
+         << endl;
+    cout << model;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/NativeModel.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NEVAL 1000000
+
+typedef chrono::high_resolution_clock Clock;
+
+int main(int argc, char* argv[])
+{
+    string source = "return p_1*exp(-p_0*x_0) + p_3*exp(-p_2*x_0);";
+    Index  nEval  = DEF_NEVAL;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<program> [<#evaluation>]]" << endl;
+        cerr << "(program variables: x_0, p_0, ..., p_3)" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        source = argv[1];
+    }
+    if (argc > 2)
+    {
+        nEval = strTo<Index>(argv[2]);
+    }
+
+    auto              start = Clock::now();
+    NativeDoubleModel native(source, 1, 4);
+    auto              time  = Clock::now() - start;
+
+    cout << "-- native model " << (native.isNative() ? "loaded" : "failed")
+         << " in " << chrono::duration<double, milli>(time).count()
+         << " ms (cache: " << NativeDoubleModel::getCacheDirectory() << ")"
+         << endl;
+    cout << "-- generated source:" << endl << native.getSource() << endl;
+
+    DoubleModel interpModel = compile(source, 1, 4);
+    DoubleModel nativeModel = native.makeModel();
+    DVec        par(4);
+    double      interpRes = 0., nativeRes = 0., x;
+
+    FOR_VEC(par, j)
+    {
+        par(j) = 0.1*(j + 1);
+    }
+    start = Clock::now();
+    for (Index i = 0; i < nEval; ++i)
+    {
+        x          = static_cast<double>(i % 64);
+        interpRes += interpModel(&x, par.data());
+    }
+    time = Clock::now() - start;
+
+    double interpNs = chrono::duration<double, nano>(time).count()/nEval;
+
+    start = Clock::now();
+    for (Index i = 0; i < nEval; ++i)
+    {
+        x          = static_cast<double>(i % 64);
+        nativeRes += nativeModel(&x, par.data());
+    }
+    time = Clock::now() - start;
+
+    double nativeNs = chrono::duration<double, nano>(time).count()/nEval;
+
+    cout << "-- " << nEval << " evaluations" << endl;
+    cout << "interpreter: " << interpNs << " ns/eval (sum= " << interpRes
+         << ")" << endl;
+    cout << "native     : " << nativeNs << " ns/eval (sum= " << nativeRes
+         << ")" << endl;
+    cout << "speedup    : " << interpNs/nativeNs << endl;
+
+    return EXIT_SUCCESS;
+}
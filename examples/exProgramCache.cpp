@@ -0,0 +1,112 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NCOMPILE 2000
+#define NTHREAD      4
+
+typedef chrono::high_resolution_clock Clock;
+
+// compile the models nCompile times from several threads (as a fit range scan
+// rebuilding its models would) and evaluate each of them once
+static double compileModels(const vector<string> &code, const Index nCompile)
+{
+    vector<thread> worker;
+    vector<double> sum(NTHREAD, 0.);
+
+    for (unsigned int t = 0; t < NTHREAD; ++t)
+    {
+        worker.emplace_back([&code, &sum, nCompile, t](void)
+        {
+            double x = 2., par[4] = {0.3, 1.0, 0.8, 0.5};
+
+            for (Index i = t; i < nCompile; i += NTHREAD)
+            {
+                CompiledDoubleModel model(code[i % code.size()], 1, 4);
+
+                sum[t] += model(&x, par);
+            }
+        });
+    }
+    for (auto &th: worker)
+    {
+        th.join();
+    }
+
+    return accumulate(sum.begin(), sum.end(), 0.);
+}
+
+static void printStatistics(void)
+{
+    auto s = ProgramCache::getInstance().getStatistics();
+
+    cout << "cache: " << s.hit << " hit(s), " << s.miss << " miss(es), "
+         << s.eviction << " eviction(s), " << s.size << "/" << s.capacity
+         << " program(s)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> code = {
+        "return p_1*exp(-p_0*x_0);",
+        "return p_1*exp(-p_0*x_0) + p_3*exp(-p_2*x_0);",
+        "return p_1*cosh(p_0*(x_0 - 32)) + p_3*cosh(p_2*(x_0 - 32));"
+    };
+    Index          nCompile = DEF_NCOMPILE;
+    ProgramCache   &cache   = ProgramCache::getInstance();
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<#compilation>]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nCompile = strTo<Index>(argv[1]);
+    }
+
+    Index  capacity = cache.getCapacity();
+    double noCacheSum, cacheSum;
+
+    // caching disabled
+    cache.setCapacity(0);
+    cache.resetStatistics();
+
+    auto start = Clock::now();
+
+    noCacheSum = compileModels(code, nCompile);
+
+    auto   time      = Clock::now() - start;
+    double noCacheUs = chrono::duration<double, micro>(time).count()/nCompile;
+
+    cout << "-- " << nCompile << " compilations without cache" << endl;
+    printStatistics();
+
+    // process-wide cache
+    cache.setCapacity(capacity);
+    cache.resetStatistics();
+    start    = Clock::now();
+    cacheSum = compileModels(code, nCompile);
+    time     = Clock::now() - start;
+
+    double cacheUs = chrono::duration<double, micro>(time).count()/nCompile;
+
+    cout << "-- " << nCompile << " compilations with cache" << endl;
+    printStatistics();
+    cout << "no cache: " << noCacheUs << " us/model (sum= " << noCacheSum
+         << ")" << endl;
+    cout << "cache   : " << cacheUs << " us/model (sum= " << cacheSum
+         << ")" << endl;
+    cout << "speedup : " << noCacheUs/cacheUs << endl;
+    if (noCacheSum != cacheSum)
+    {
+        cerr << "error: results mismatch" << endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Statistics/Dataset.hpp>
+#include <LatAnalyze/Statistics/StatAccumulator.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NDATA 10000
+#define NT        8
+#define NTHREAD   4
+
+static double relDiff(const DMat &a, const DMat &b)
+{
+    return (a - b).cwiseAbs().maxCoeff()/b.cwiseAbs().maxCoeff();
+}
+
+int main(int argc, char *argv[])
+{
+    Index nData = DEF_NDATA;
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<#data>]" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nData = strTo<Index>(argv[1]);
+    }
+
+    // correlated column vector data
+    mt19937               gen(42);
+    normal_distribution<> dis;
+    Dataset<DMat>         data(nData);
+
+    for (Index i = 0; i < nData; ++i)
+    {
+        double z = dis(gen);
+
+        data[i].resize(NT, 1);
+        for (Index t = 0; t < NT; ++t)
+        {
+            data[i](t) = exp(-0.2*t)*(1. + 0.1*z + 0.05*dis(gen));
+        }
+    }
+
+    // each thread accumulates a contiguous chunk, the results are merged
+    vector<StatAccumulator<DMat>> acc(NTHREAD, StatAccumulator<DMat>(true));
+    vector<thread>                worker;
+
+    for (Index th = 0; th < NTHREAD; ++th)
+    {
+        worker.emplace_back([&data, &acc, th, nData](void)
+        {
+            for (Index i = th*nData/NTHREAD; i < (th + 1)*nData/NTHREAD; ++i)
+            {
+                acc[th].push(data[i]);
+            }
+        });
+    }
+    for (auto &w: worker)
+    {
+        w.join();
+    }
+    for (Index th = 1; th < NTHREAD; ++th)
+    {
+        acc[0] += acc[th];
+    }
+
+    double meanDiff = relDiff(acc[0].mean(), data.mean());
+    double varDiff  = relDiff(acc[0].variance(), data.variance());
+    double covDiff  = relDiff(acc[0].varianceMatrix(), data.varianceMatrix());
+
+    // invalid data must leave the accumulator untouched
+    StatAccumulator<DMat> badAcc(true);
+    bool                  isRejected = false;
+
+    try
+    {
+        badAcc.push(DMat::Ones(2, 2));
+    }
+    catch (const Exceptions::Size &)
+    {
+        isRejected = (badAcc.size() == 0);
+    }
+
+    cout << "-- " << nData << " data, " << NTHREAD << " threads" << endl;
+    cout << "merged size             : " << acc[0].size() << endl;
+    cout << "mean relative diff.     : " << meanDiff << endl;
+    cout << "variance relative diff. : " << varDiff << endl;
+    cout << "covariance relative diff: " << covDiff << endl;
+    cout << "non-vector data rejected: " << (isRejected ? "yes" : "no")
+         << endl;
+
+    return ((acc[0].size() == nData) and (meanDiff < 1.0e-10)
+            and (varDiff < 1.0e-10) and (covDiff < 1.0e-10) and isRejected)
+           ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,56 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Core/MathDerivative.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+#include <LatAnalyze/Numerical/Derivative.hpp>
+
+using namespace std;
+using namespace Latan;
+
+int main(int argc, char* argv[])
+{
+    string source = "a = exp(-p_1*x_0); b = p_2*cos(p_3*x_0)/(1 + x_0^2);"
+                    " return p_0*a + b^2 + atan2(p_3, x_0);";
+
+    if (argc > 2)
+    {
+        cerr << "usage: " << argv[0] << " [<program>]" << endl;
+        cerr << "(program variables: x_0, p_0, ..., p_3)" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        source = argv[1];
+    }
+
+    CompiledDoubleModel model(source, 1, 4);
+    DVec                x(1), par(4);
+    double              maxErr = 0.;
+
+    x(0) = 1.3;
+    par << 0.7, 0.4, -1.1, 2.5;
+    cout << "-- program: " << source << endl;
+    cout << "-- derivatives at x_0= " << x(0) << ", p= " << par.transpose()
+         << endl;
+    for (Index j = 0; j < 5; ++j)
+    {
+        string              var = (j == 0) ? "x_0" : "p_" + strFrom(j - 1);
+        CompiledDoubleModel d   = (j == 0) ? model.argDerivative(0)
+                                           : model.parDerivative(j - 1);
+        DoubleFunction      f   = (j == 0) ? model.makeModel().fixPar(par)
+                                           : model.makeModel().fixArg(x);
+        CentralDerivative   num(f, (j == 0) ? 0 : j - 1);
+        double              exact, numerical;
+
+        exact     = d(x.data(), par.data());
+        numerical = (j == 0) ? num(x.data()) : num(par.data());
+        maxErr    = max(maxErr, fabs(exact - numerical)
+                                /max(1., fabs(numerical)));
+        cout << "d/d" << var << ": " << d.getCode() << endl;
+        cout << "  symbolic= " << setprecision(15) << exact
+             << " numerical= " << numerical << endl;
+    }
+    cout << "-- maximum relative difference: " << maxErr << endl;
+
+    return (maxErr < 1.0e-6) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
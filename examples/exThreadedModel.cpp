@@ -0,0 +1,115 @@
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+
+using namespace std;
+using namespace Latan;
+
+#define DEF_NTHREAD 8
+#define DEF_NEVAL   200000
+#define NPOINT      64
+
+// evaluate the model on the points x for the parameter set number k
+static void evalModel(double *res, const DoubleModel &model, const DVec &x,
+                      const Index k, const bool batch)
+{
+    DVec par(3);
+
+    par << 1. + 0.01*k, 0.1 + 0.001*k, 0.5 - 0.002*k;
+    if (batch)
+    {
+        model(res, x.data(), par.data(), x.size());
+    }
+    else
+    {
+        FOR_VEC(x, i)
+        {
+            res[i] = model(x.data() + i, par.data());
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Index nThread = DEF_NTHREAD, nEval = DEF_NEVAL;
+
+    if (argc > 3)
+    {
+        cerr << "usage: " << argv[0] << " [<#thread> [<#evaluation/thread>]]"
+             << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        nThread = strTo<Index>(argv[1]);
+    }
+    if (argc > 2)
+    {
+        nEval = strTo<Index>(argv[2]);
+    }
+
+    // model with an intermediate variable to check that the program
+    // variables are private to each thread
+    CompiledDoubleModel compiled("a = exp(-p_1*x_0); return p_0*a + p_2*a^2;",
+                                 1, 3);
+    DoubleModel         model = compiled.makeModel(false);
+    const Index         nSet  = nEval/NPOINT;
+    DVec                x(NPOINT);
+    DMat                ref(NPOINT, nSet);
+
+    FOR_VEC(x, i)
+    {
+        x(i) = static_cast<double>(i);
+    }
+    cout << "-- serial reference (" << nSet << " parameter sets)" << endl;
+    for (Index k = 0; k < nSet; ++k)
+    {
+        evalModel(ref.col(k).data(), model, x, k, false);
+    }
+
+    // all threads evaluate the same model concurrently, alternating between
+    // single point and batched calls, and compare with the serial results
+    vector<thread>       pool;
+    vector<Index>        nError(nThread, 0);
+    atomic<bool>         go{false};
+
+    cout << "-- " << nThread << " threads x " << nSet*NPOINT
+         << " evaluations" << endl;
+    auto start = chrono::high_resolution_clock::now();
+    for (Index t = 0; t < nThread; ++t)
+    {
+        pool.emplace_back([&, t](void)
+        {
+            DVec res(NPOINT);
+
+            while (!go);
+            for (Index k = 0; k < nSet; ++k)
+            {
+                evalModel(res.data(), model, x, k, (k + t) % 2);
+                if (res != ref.col(k))
+                {
+                    nError[t]++;
+                }
+            }
+        });
+    }
+    go = true;
+    for (auto &th: pool)
+    {
+        th.join();
+    }
+    auto time = chrono::high_resolution_clock::now() - start;
+
+    Index totError = 0;
+
+    for (Index t = 0; t < nThread; ++t)
+    {
+        totError += nError[t];
+    }
+    cout << "time  : " << chrono::duration<double, milli>(time).count()
+         << " ms" << endl;
+    cout << "errors: " << totError << "/" << nThread*nSet << " evaluations"
+         << " of " << NPOINT << " points" << endl;
+
+    return (totError == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
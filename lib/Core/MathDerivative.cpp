@@ -0,0 +1,428 @@
+/*
+ * MathDerivative.cpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LatAnalyze/Core/MathDerivative.hpp>
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/includes.hpp>
+
+using namespace std;
+using namespace Latan;
+
+/******************************************************************************
+ *                          AST differentiation                               *
+ ******************************************************************************/
+// in the following a null node represents an exact zero, which is propagated
+// through the arithmetic to prune the derivative tree
+typedef unique_ptr<ExprNode> Node;
+
+struct DiffState
+{
+    string      var, prefix;
+    set<string> active;
+};
+
+// node builders ///////////////////////////////////////////////////////////////
+static Node cst(const double val)
+{
+    return Node(new CstNode(val));
+}
+
+static Node var(const string &name)
+{
+    return Node(new VarNode(name));
+}
+
+static Node copy(const ExprNode &n)
+{
+    return Node(n.clone());
+}
+
+static Node op(const string &name, Node a, Node b = nullptr)
+{
+    Node n(new MathOpNode(name));
+
+    n->pushArg(a.release());
+    n->pushArg(b.release());
+
+    return n;
+}
+
+static Node func(const string &name, Node a, Node b = nullptr)
+{
+    Node n(new FuncNode(name));
+
+    n->pushArg(a.release());
+    n->pushArg(b.release());
+
+    return n;
+}
+
+static Node neg(Node a)
+{
+    return a ? op("-", move(a)) : nullptr;
+}
+
+static Node add(Node a, Node b)
+{
+    if (!a)
+    {
+        return b;
+    }
+    else if (!b)
+    {
+        return a;
+    }
+    else
+    {
+        return op("+", move(a), move(b));
+    }
+}
+
+static Node sub(Node a, Node b)
+{
+    if (!b)
+    {
+        return a;
+    }
+    else if (!a)
+    {
+        return neg(move(b));
+    }
+    else
+    {
+        return op("-", move(a), move(b));
+    }
+}
+
+static Node mul(Node a, Node b)
+{
+    return (a and b) ? op("*", move(a), move(b)) : nullptr;
+}
+
+static Node div(Node a, Node b)
+{
+    return a ? op("/", move(a), move(b)) : nullptr;
+}
+
+static Node sq(Node a)
+{
+    return op("^", move(a), cst(2.));
+}
+
+// expression derivative ///////////////////////////////////////////////////////
+static Node diffExpr(const ExprNode &n, const DiffState &s);
+
+// d(u^w) = w*u^(w - 1)*du + u^w*log(u)*dw
+static Node diffPow(const ExprNode &u, const ExprNode &w, const DiffState &s)
+{
+    Node du = diffExpr(u, s), dw = diffExpr(w, s);
+
+    if (!dw)
+    {
+        return mul(mul(copy(w), op("^", copy(u), sub(copy(w), cst(1.)))),
+                   move(du));
+    }
+    else if (!du)
+    {
+        return mul(mul(op("^", copy(u), copy(w)), func("log", copy(u))),
+                   move(dw));
+    }
+    else
+    {
+        return mul(op("^", copy(u), copy(w)),
+                   add(mul(move(dw), func("log", copy(u))),
+                       div(mul(copy(w), move(du)), copy(u))));
+    }
+}
+
+#define IFFUNC(fname) if (name == (fname))
+#define ELIFFUNC(fname) else IFFUNC(fname)
+
+// f'(u) for the single-argument standard functions, null if f' = 0
+static Node stdMathDerivative(const string &name, const ExprNode &u)
+{
+    auto one = [](void) {return cst(1.);};
+    auto f   = [&u](const string &fname) {return func(fname, copy(u));};
+
+    IFFUNC("cos")       return neg(f("sin"));
+    ELIFFUNC("sin")     return f("cos");
+    ELIFFUNC("tan")     return div(one(), sq(f("cos")));
+    ELIFFUNC("acos")    return neg(div(one(), func("sqrt",
+                                   sub(one(), sq(copy(u))))));
+    ELIFFUNC("asin")    return div(one(), func("sqrt",
+                                   sub(one(), sq(copy(u)))));
+    ELIFFUNC("atan")    return div(one(), add(one(), sq(copy(u))));
+    ELIFFUNC("cosh")    return f("sinh");
+    ELIFFUNC("sinh")    return f("cosh");
+    ELIFFUNC("tanh")    return div(one(), sq(f("cosh")));
+    ELIFFUNC("acosh")   return div(one(), func("sqrt",
+                                   sub(sq(copy(u)), one())));
+    ELIFFUNC("asinh")   return div(one(), func("sqrt",
+                                   add(sq(copy(u)), one())));
+    ELIFFUNC("atanh")   return div(one(), sub(one(), sq(copy(u))));
+    ELIFFUNC("exp")     return f("exp");
+    ELIFFUNC("log")     return div(one(), copy(u));
+    ELIFFUNC("log10")   return div(one(), mul(copy(u), cst(log(10.))));
+    ELIFFUNC("exp2")    return mul(f("exp2"), cst(log(2.)));
+    ELIFFUNC("expm1")   return f("exp");
+    ELIFFUNC("log1p")   return div(one(), add(one(), copy(u)));
+    ELIFFUNC("log2")    return div(one(), mul(copy(u), cst(log(2.))));
+    ELIFFUNC("sqrt")    return div(one(), mul(cst(2.), f("sqrt")));
+    ELIFFUNC("cbrt")    return div(one(), mul(cst(3.), sq(f("cbrt"))));
+    ELIFFUNC("erf")     return mul(cst(2./sqrt(Math::pi)),
+                                   func("exp", neg(sq(copy(u)))));
+    ELIFFUNC("erfc")    return mul(cst(-2./sqrt(Math::pi)),
+                                   func("exp", neg(sq(copy(u)))));
+    ELIFFUNC("fabs")    return div(copy(u), f("fabs"));
+    ELIFFUNC("ceil")    return nullptr;
+    ELIFFUNC("floor")   return nullptr;
+    ELIFFUNC("trunc")   return nullptr;
+    ELIFFUNC("round")   return nullptr;
+    ELIFFUNC("rint")    return nullptr;
+    ELIFFUNC("nearbyint") return nullptr;
+    else
+    {
+        LATAN_ERROR(Implementation, "no symbolic derivative for function '"
+                    + name + "' with 1 argument");
+    }
+}
+
+static Node diffFunc(const ExprNode &n, const DiffState &s)
+{
+    const string &name = n.getName();
+
+    if (n.getNArg() == 1)
+    {
+        Node du = diffExpr(n[0], s);
+
+        return du ? mul(stdMathDerivative(name, n[0]), move(du)) : nullptr;
+    }
+    else if (n.getNArg() == 2)
+    {
+        const ExprNode &a = n[0], &b = n[1];
+
+        IFFUNC("pow")
+        {
+            return diffPow(a, b, s);
+        }
+        ELIFFUNC("atan2")
+        {
+            return div(sub(mul(copy(b), diffExpr(a, s)),
+                           mul(copy(a), diffExpr(b, s))),
+                       add(sq(copy(b)), sq(copy(a))));
+        }
+        ELIFFUNC("hypot")
+        {
+            return div(add(mul(copy(a), diffExpr(a, s)),
+                           mul(copy(b), diffExpr(b, s))),
+                       func("hypot", copy(a), copy(b)));
+        }
+        ELIFFUNC("fmod")
+        {
+            return sub(diffExpr(a, s),
+                       mul(func("trunc", op("/", copy(a), copy(b))),
+                           diffExpr(b, s)));
+        }
+        ELIFFUNC("remainder")
+        {
+            return sub(diffExpr(a, s),
+                       mul(func("rint", op("/", copy(a), copy(b))),
+                           diffExpr(b, s)));
+        }
+    }
+    LATAN_ERROR(Implementation, "no symbolic derivative for function '"
+                + name + "' with " + strFrom(n.getNArg()) + " argument(s)");
+}
+
+#define IFNODE(name, nArg) if ((n.getName() == (name)) and (n.getNArg() == nArg))
+#define ELIFNODE(name, nArg) else IFNODE(name, nArg)
+
+static Node diffExpr(const ExprNode &n, const DiffState &s)
+{
+    if (dynamic_cast<const CstNode *>(&n))
+    {
+        return nullptr;
+    }
+    else if (isDerivedFrom<VarNode>(&n))
+    {
+        if (s.active.find(n.getName()) != s.active.end())
+        {
+            return var(s.prefix + n.getName());
+        }
+        else
+        {
+            return (n.getName() == s.var) ? cst(1.) : nullptr;
+        }
+    }
+    else if (isDerivedFrom<MathOpNode>(&n))
+    {
+        IFNODE("-", 1)
+        {
+            return neg(diffExpr(n[0], s));
+        }
+        ELIFNODE("+", 2)
+        {
+            return add(diffExpr(n[0], s), diffExpr(n[1], s));
+        }
+        ELIFNODE("-", 2)
+        {
+            return sub(diffExpr(n[0], s), diffExpr(n[1], s));
+        }
+        ELIFNODE("*", 2)
+        {
+            return add(mul(diffExpr(n[0], s), copy(n[1])),
+                       mul(copy(n[0]), diffExpr(n[1], s)));
+        }
+        ELIFNODE("/", 2)
+        {
+            return sub(div(diffExpr(n[0], s), copy(n[1])),
+                       div(mul(copy(n[0]), diffExpr(n[1], s)),
+                           sq(copy(n[1]))));
+        }
+        ELIFNODE("^", 2)
+        {
+            return diffPow(n[0], n[1], s);
+        }
+    }
+    else if (isDerivedFrom<FuncNode>(&n))
+    {
+        return diffFunc(n, s);
+    }
+    LATAN_ERROR(Implementation, "no symbolic derivative for node '"
+                + n.getName() + "'");
+}
+
+// program derivative //////////////////////////////////////////////////////////
+// the derivative of an assigned variable is computed before the variable is
+// updated, so that self-referencing assignments use the previous values;
+// returns true once a return statement has been differentiated
+static bool diffStatement(ExprNode &program, const ExprNode &n, DiffState &s)
+{
+    if (isDerivedFrom<SemicolonNode>(&n))
+    {
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            if (diffStatement(program, n[i], s))
+            {
+                return true;
+            }
+        }
+    }
+    else if (isDerivedFrom<AssignNode>(&n))
+    {
+        const string &name = n[0].getName();
+        Node         da    = diffExpr(n[1], s);
+
+        if (da or (name == s.var) or (s.active.find(name) != s.active.end()))
+        {
+            ExprNode *assign = new AssignNode("=");
+
+            assign->pushArg(new VarNode(s.prefix + name));
+            assign->pushArg(da ? da.release() : new CstNode(0.));
+            program.pushArg(assign);
+            s.active.insert(name);
+        }
+        program.pushArg(n.clone());
+    }
+    else if (isDerivedFrom<ReturnNode>(&n))
+    {
+        ExprNode *ret = new ReturnNode("return");
+
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            Node dr = diffExpr(n[i], s);
+
+            ret->pushArg(dr ? dr.release() : new CstNode(0.));
+        }
+        program.pushArg(ret);
+
+        return true;
+    }
+
+    return false;
+}
+
+// remove the assignments which do not contribute to the returned value,
+// program is a flat list of statements ending with the return statement
+static Node removeDeadCode(ExprNode &program)
+{
+    set<string>  live;
+    vector<bool> keep(program.getNArg(), true);
+    Node         res(new SemicolonNode(";"));
+
+    for (Index i = program.getNArg() - 1; i >= 0; --i)
+    {
+        const ExprNode &n = program[i];
+
+        if (isDerivedFrom<AssignNode>(&n))
+        {
+            keep[i] = (live.find(n[0].getName()) != live.end());
+            if (keep[i])
+            {
+                live.erase(n[0].getName());
+                getVariableNames(live, n[1]);
+            }
+        }
+        else
+        {
+            getVariableNames(live, n);
+        }
+    }
+    for (Index i = 0; i < program.getNArg(); ++i)
+    {
+        if (keep[i])
+        {
+            res->pushArg(program.releaseArg(i));
+        }
+    }
+
+    return res;
+}
+
+unique_ptr<ExprNode> Latan::derivative(const ExprNode &ast, const string &var)
+{
+    DiffState   s;
+    set<string> names;
+    Node        program(new SemicolonNode(";"));
+
+    // prefix for the derivative variables which does not collide with the
+    // program variable names
+    getVariableNames(names, ast);
+    s.var    = var;
+    s.prefix = uniquePrefix(names, "_d_");
+    if (!diffStatement(*program, ast, s))
+    {
+        LATAN_ERROR(Syntax, "expected 'return' in program");
+    }
+
+    return removeDeadCode(*program);
+}
+
+string Latan::derivativeCode(const string &code, const string &var)
+{
+    MathInterpreter interpreter(code);
+
+    interpreter.parse();
+    if (!interpreter.getAST())
+    {
+        LATAN_ERROR(Syntax, "expected 'return' in program '" + code + "'");
+    }
+
+    return toCode(*derivative(*interpreter.getAST(), var));
+}
@@ -0,0 +1,45 @@
+/*
+ * MathDerivative.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_MathDerivative_hpp_
+#define Latan_MathDerivative_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Core/MathInterpreter.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                     Symbolic differentiation of programs                   *
+ ******************************************************************************/
+// AST of a program returning the derivative with respect to the variable var
+// of the value(s) returned by the program ast; each assigned variable a gets a
+// companion variable holding da/dvar, computed just before a itself.
+// Piecewise constant functions (floor, round, ...) have a zero derivative,
+// fabs has derivative sign(x) (undefined at 0), and fdim, fmax, fmin,
+// tgamma and lgamma are not supported.
+std::unique_ptr<ExprNode> derivative(const ExprNode &ast,
+                                     const std::string &var);
+
+// same as above, directly from the program code
+std::string derivativeCode(const std::string &code, const std::string &var);
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_MathDerivative_hpp_
@@ -0,0 +1,537 @@
+/*
+ * MathFusion.cpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LatAnalyze/Core/MathFusion.hpp>
+#include <LatAnalyze/includes.hpp>
+
+using namespace std;
+using namespace Latan;
+
+typedef unique_ptr<ExprNode> Node;
+
+// statements of a program in execution order, up to the first return
+// statement which is the last element, returns false if there is no return
+static bool getStatements(vector<const ExprNode *> &stmt, const ExprNode &n)
+{
+    if (isDerivedFrom<SemicolonNode>(&n))
+    {
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            if (getStatements(stmt, n[i]))
+            {
+                return true;
+            }
+        }
+    }
+    else if (isDerivedFrom<AssignNode>(&n))
+    {
+        stmt.push_back(&n);
+    }
+    else if (isDerivedFrom<ReturnNode>(&n))
+    {
+        stmt.push_back(&n);
+
+        return true;
+    }
+
+    return false;
+}
+
+static Node makeAssign(const string &name, Node rhs)
+{
+    Node assign(new AssignNode("="));
+
+    assign->pushArg(new VarNode(name));
+    assign->pushArg(rhs.release());
+
+    return assign;
+}
+
+/******************************************************************************
+ *                            Program fusion                                  *
+ ******************************************************************************/
+static void renameVariables(ExprNode &n, const set<string> &assigned,
+                            const string &prefix)
+{
+    if (isDerivedFrom<VarNode>(&n)
+        and (assigned.find(n.getName()) != assigned.end()))
+    {
+        n.setName(prefix + n.getName());
+    }
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        ExprNode *arg = n.releaseArg(i);
+
+        renameVariables(*arg, assigned, prefix);
+        n.setArg(i, arg);
+    }
+}
+
+// a variable is renamed from its first assignment on, before that it refers
+// to the input variable of the same name
+unique_ptr<ExprNode> Latan::fuse(const vector<const ExprNode *> &ast)
+{
+    set<string> names;
+    string      prefix;
+    Node        program(new SemicolonNode(";")), ret(new ReturnNode("return"));
+
+    for (auto a: ast)
+    {
+        if (a)
+        {
+            getVariableNames(names, *a);
+        }
+    }
+    prefix = uniquePrefix(names, "_f");
+    for (unsigned int k = 0; k < ast.size(); ++k)
+    {
+        vector<const ExprNode *> stmt;
+        set<string>              assigned;
+        const string             p = prefix + strFrom(k) + "_";
+
+        if (!ast[k] or !getStatements(stmt, *ast[k]))
+        {
+            LATAN_ERROR(Syntax, "expected 'return' in program "
+                        + strFrom(k));
+        }
+        for (auto s: stmt)
+        {
+            auto &n = *s;
+
+            if (isDerivedFrom<AssignNode>(s))
+            {
+                Node rhs(n[1].clone());
+
+                renameVariables(*rhs, assigned, p);
+                assigned.insert(n[0].getName());
+                program->pushArg(makeAssign(p + n[0].getName(),
+                                            move(rhs)).release());
+            }
+            else
+            {
+                for (Index i = 0; i < n.getNArg(); ++i)
+                {
+                    Node e(n[i].clone());
+
+                    renameVariables(*e, assigned, p);
+                    ret->pushArg(e.release());
+                }
+            }
+        }
+    }
+    program->pushArg(ret.release());
+
+    return program;
+}
+
+/******************************************************************************
+ *                    Common subexpression elimination                        *
+ ******************************************************************************/
+// subexpressions are identified by a key where each variable is tagged with
+// the number of times it has been assigned so far, so that equal keys mean
+// equal values
+struct SubexprKey
+{
+    string key;
+    bool   isVariable;
+};
+
+struct CseState
+{
+    map<const ExprNode *, SubexprKey> key;
+    map<string, Index>                count;
+    map<string, string>               temp;
+    map<string, unsigned int>         version;
+    string                            prefix;
+    ExprNode                          *program;
+};
+
+static const SubexprKey & makeKey(const ExprNode &n, CseState &s)
+{
+    const CstNode *c = dynamic_cast<const CstNode *>(&n);
+    SubexprKey    k;
+
+    if (c)
+    {
+        ostringstream buf;
+
+        buf << "c" << hexfloat << c->getValue();
+        k.key        = buf.str();
+        k.isVariable = false;
+    }
+    else if (isDerivedFrom<VarNode>(&n))
+    {
+        k.key        = "v" + n.getName() + "#"
+                       + strFrom(s.version[n.getName()]);
+        k.isVariable = true;
+    }
+    else
+    {
+        k.key        = n.getName() + "(";
+        k.isVariable = false;
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            const SubexprKey &a = makeKey(n[i], s);
+
+            k.key        += ((i > 0) ? "," : "") + a.key;
+            k.isVariable  = k.isVariable or a.isVariable;
+        }
+        k.key += ")";
+    }
+
+    return s.key[&n] = k;
+}
+
+// constant subexpressions are left to the optimizer and negations of leaves
+// are cheaper to recompute than to store
+static bool isCandidate(const ExprNode &n, const CseState &s)
+{
+    if ((n.getNArg() == 0) or !s.key.at(&n).isVariable)
+    {
+        return false;
+    }
+    else if (isDerivedFrom<MathOpNode>(&n) and (n.getNArg() == 1)
+             and (n[0].getNArg() == 0))
+    {
+        return false;
+    }
+    else
+    {
+        return true;
+    }
+}
+
+static bool isCommon(const ExprNode &n, const CseState &s)
+{
+    return isCandidate(n, s) and (s.count.at(s.key.at(&n).key) > 1);
+}
+
+// the subexpressions of a repeated occurrence are not counted since they are
+// not evaluated again
+static void countSubexpr(const ExprNode &n, CseState &s)
+{
+    if (isCandidate(n, s) and (++s.count[s.key.at(&n).key] > 1))
+    {
+        return;
+    }
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        countSubexpr(n[i], s);
+    }
+}
+
+static Node replaceSubexpr(const ExprNode &n, CseState &s)
+{
+    bool common = isCommon(n, s);
+    Node res;
+
+    if (common)
+    {
+        auto it = s.temp.find(s.key.at(&n).key);
+
+        if (it != s.temp.end())
+        {
+            return Node(new VarNode(it->second));
+        }
+    }
+    res.reset(n.clone());
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        res->setArg(i, replaceSubexpr(n[i], s).release());
+    }
+    if (common)
+    {
+        string name = s.prefix + strFrom(s.temp.size());
+
+        s.temp[s.key.at(&n).key] = name;
+        s.program->pushArg(makeAssign(name, move(res)).release());
+        res.reset(new VarNode(name));
+    }
+
+    return res;
+}
+
+unique_ptr<ExprNode> Latan::eliminateCommonSubexpr(const ExprNode &ast)
+{
+    vector<const ExprNode *> stmt;
+    set<string>              names;
+    CseState                 s;
+    Node                     program(new SemicolonNode(";"));
+
+    if (!getStatements(stmt, ast))
+    {
+        LATAN_ERROR(Syntax, "expected 'return' in program");
+    }
+    getVariableNames(names, ast);
+    s.prefix  = uniquePrefix(names, "_c");
+    s.program = program.get();
+    for (auto st: stmt)
+    {
+        auto &n = *st;
+
+        if (isDerivedFrom<AssignNode>(st))
+        {
+            makeKey(n[1], s);
+            countSubexpr(n[1], s);
+            s.version[n[0].getName()]++;
+        }
+        else
+        {
+            for (Index i = 0; i < n.getNArg(); ++i)
+            {
+                makeKey(n[i], s);
+                countSubexpr(n[i], s);
+            }
+        }
+    }
+    for (auto st: stmt)
+    {
+        auto &n = *st;
+
+        if (isDerivedFrom<AssignNode>(st))
+        {
+            Node rhs = replaceSubexpr(n[1], s);
+
+            program->pushArg(makeAssign(n[0].getName(), move(rhs)).release());
+        }
+        else
+        {
+            Node ret(new ReturnNode("return"));
+
+            for (Index i = 0; i < n.getNArg(); ++i)
+            {
+                ret->pushArg(replaceSubexpr(n[i], s).release());
+            }
+            program->pushArg(ret.release());
+        }
+    }
+
+    return program;
+}
+
+string Latan::fuseCode(const vector<string> &code)
+{
+    vector<unique_ptr<MathInterpreter>> interpreter;
+    vector<const ExprNode *>            ast;
+
+    for (auto &c: code)
+    {
+        interpreter.emplace_back(new MathInterpreter(c));
+        interpreter.back()->parse();
+        ast.push_back(interpreter.back()->getAST());
+    }
+
+    return toCode(*eliminateCommonSubexpr(*fuse(ast)));
+}
+
+/******************************************************************************
+ *                     Loop-invariant code motion                             *
+ ******************************************************************************/
+// a variable is invariant if it is not a point variable and if it is either
+// an input or only assigned once by a statement moved to the prelude
+struct HoistState
+{
+    set<string>         pointVar, assigned, read, invariant;
+    map<string, string> temp;
+    string              prefix;
+    ExprNode            *prelude;
+    vector<string>      *output;
+};
+
+static bool isInvariant(const ExprNode &n, const HoistState &s)
+{
+    if (isDerivedFrom<VarNode>(&n))
+    {
+        const string &name = n.getName();
+
+        return (s.pointVar.find(name) == s.pointVar.end())
+               and ((s.assigned.find(name) == s.assigned.end())
+                    or (s.invariant.find(name) != s.invariant.end()));
+    }
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        if (!isInvariant(n[i], s))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool hasVariable(const ExprNode &n)
+{
+    if (isDerivedFrom<VarNode>(&n))
+    {
+        return true;
+    }
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        if (hasVariable(n[i]))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// same criteria as common subexpression elimination: leaves, constant
+// subexpressions and negations of leaves are not worth a variable
+static bool isHoistable(const ExprNode &n, const HoistState &s)
+{
+    if ((n.getNArg() == 0) or !hasVariable(n))
+    {
+        return false;
+    }
+    else if (isDerivedFrom<MathOpNode>(&n) and (n.getNArg() == 1)
+             and (n[0].getNArg() == 0))
+    {
+        return false;
+    }
+    else
+    {
+        return isInvariant(n, s);
+    }
+}
+
+static void getReadVariables(set<string> &read, const ExprNode &n)
+{
+    if (isDerivedFrom<VarNode>(&n))
+    {
+        read.insert(n.getName());
+    }
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        getReadVariables(read, n[i]);
+    }
+}
+
+static Node hoistSubexpr(const ExprNode &n, HoistState &s)
+{
+    if (isHoistable(n, s))
+    {
+        const string key = toCode(n);
+        auto         it  = s.temp.find(key);
+
+        if (it == s.temp.end())
+        {
+            const string name = s.prefix + strFrom(s.temp.size());
+
+            it = s.temp.insert({key, name}).first;
+            s.prelude->pushArg(makeAssign(name, Node(n.clone())).release());
+            s.output->push_back(name);
+        }
+
+        return Node(new VarNode(it->second));
+    }
+
+    Node res(n.clone());
+
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        res->setArg(i, hoistSubexpr(n[i], s).release());
+    }
+
+    return res;
+}
+
+bool Latan::hoistInvariant(unique_ptr<ExprNode> &prelude,
+                           unique_ptr<ExprNode> &body,
+                           vector<string> &preludeOutput,
+                           const ExprNode &ast, const set<string> &pointVar)
+{
+    vector<const ExprNode *> stmt;
+    set<string>              names, assignedTwice;
+    HoistState               s;
+
+    if (!getStatements(stmt, ast))
+    {
+        LATAN_ERROR(Syntax, "expected 'return' in program");
+    }
+    for (auto st: stmt)
+    {
+        if (isDerivedFrom<AssignNode>(st)
+            and !s.assigned.insert((*st)[0].getName()).second)
+        {
+            assignedTwice.insert((*st)[0].getName());
+        }
+    }
+    getVariableNames(names, ast);
+    prelude.reset(new SemicolonNode(";"));
+    body.reset(new SemicolonNode(";"));
+    preludeOutput.clear();
+    s.pointVar = pointVar;
+    s.prefix   = uniquePrefix(names, "_h");
+    s.prelude  = prelude.get();
+    s.output   = &preludeOutput;
+    for (auto st: stmt)
+    {
+        auto &n = *st;
+
+        if (isDerivedFrom<AssignNode>(st))
+        {
+            const string &name = n[0].getName();
+
+            // a variable read before its assignment refers to the input
+            // variable and its assignment cannot be moved
+            if ((pointVar.find(name) == pointVar.end())
+                and (assignedTwice.find(name) == assignedTwice.end())
+                and (s.read.find(name) == s.read.end())
+                and isInvariant(n[1], s))
+            {
+                prelude->pushArg(makeAssign(name,
+                                            Node(n[1].clone())).release());
+                preludeOutput.push_back(name);
+                s.invariant.insert(name);
+            }
+            else
+            {
+                Node rhs = hoistSubexpr(n[1], s);
+
+                body->pushArg(makeAssign(name, move(rhs)).release());
+            }
+            getReadVariables(s.read, n[1]);
+        }
+        else
+        {
+            Node ret(new ReturnNode("return"));
+
+            for (Index i = 0; i < n.getNArg(); ++i)
+            {
+                ret->pushArg(hoistSubexpr(n[i], s).release());
+            }
+            body->pushArg(ret.release());
+        }
+    }
+    if (preludeOutput.empty())
+    {
+        return false;
+    }
+
+    Node ret(new ReturnNode("return"));
+
+    for (auto &name: preludeOutput)
+    {
+        ret->pushArg(new VarNode(name));
+    }
+    prelude->pushArg(ret.release());
+
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * MathFusion.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_MathFusion_hpp_
+#define Latan_MathFusion_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Core/MathInterpreter.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                  Program fusion and subexpression elimination              *
+ ******************************************************************************/
+// AST of a single program returning, in order, the values returned by each of
+// the programs in ast; the variables assigned by a program are renamed so that
+// the programs cannot interfere with each other
+std::unique_ptr<ExprNode> fuse(const std::vector<const ExprNode *> &ast);
+
+// common subexpression elimination: the subexpressions evaluated several
+// times with the same variable values are computed once, just before the
+// statement where they first appear, and stored in a temporary variable
+std::unique_ptr<ExprNode> eliminateCommonSubexpr(const ExprNode &ast);
+
+// fusion of the programs given as code, followed by common subexpression
+// elimination
+std::string fuseCode(const std::vector<std::string> &code);
+
+// split of the program ast into a prelude, which only depends on the
+// variables not in pointVar and is evaluated once, and a body evaluated for
+// each point: the assignments and the subexpressions invariant with respect
+// to pointVar are moved to the prelude, which returns, in order, the values
+// of the variables in preludeOutput read by the body; returns false if there
+// is nothing to hoist
+bool hoistInvariant(std::unique_ptr<ExprNode> &prelude,
+                    std::unique_ptr<ExprNode> &body,
+                    std::vector<std::string> &preludeOutput,
+                    const ExprNode &ast, const std::set<std::string> &pointVar);
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_MathFusion_hpp_
@@ -24,6 +24,34 @@
 using namespace std;
 using namespace Latan;
 
+/******************************************************************************
+ *                     ExecutionProfile implementation                        *
+ ******************************************************************************/
+// access //////////////////////////////////////////////////////////////////////
+bool ExecutionProfile::isEnabled(void) const
+{
+    return enabled_.load(memory_order_relaxed);
+}
+
+void ExecutionProfile::enable(const bool enable)
+{
+    enabled_.store(enable, memory_order_relaxed);
+}
+
+vector<InstructionProfile> ExecutionProfile::get(void) const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    return profile_;
+}
+
+void ExecutionProfile::reset(void)
+{
+    lock_guard<mutex> lock(mutex_);
+
+    profile_.clear();
+}
+
 /******************************************************************************
  *                       RunContext implementation                            *
  ******************************************************************************/
@@ -108,6 +136,11 @@ unsigned int RunContext::getInsIndex(void) const
     return insIndex_;
 }
 
+ExecutionProfile * RunContext::getProfile(void) const
+{
+    return profile_;
+}
+
 double RunContext::getVariable(const string &name) const
 {
     return getVariable(getVariableAddress(name));
@@ -174,6 +207,11 @@ void RunContext::setInsIndex(const unsigned index)
     insIndex_ = index;
 }
 
+void RunContext::setProfile(ExecutionProfile *profile)
+{
+    profile_ = profile;
+}
+
 void RunContext::setVariable(const string &name, const double value)
 {
     setVariable(getVariableAddress(name), value);
@@ -205,12 +243,129 @@ void RunContext::reset(void)
     {
         dStack_.pop();
     }
+    vmStack_.clear();
+    vmLaneStack_.clear();
+    vmLaneVar_.clear();
+    vmProfile_.clear();
+    profile_ = nullptr;
     vMem_.clear();
     fMem_.clear();
     vTable_.clear();
     fTable_.clear();
 }
 
+/******************************************************************************
+ *                         ByteCode implementation                            *
+ ******************************************************************************/
+// access //////////////////////////////////////////////////////////////////////
+const ByteCode::Op * ByteCode::data(void) const
+{
+    return code_.data();
+}
+
+const double * ByteCode::constantData(void) const
+{
+    return constant_.data();
+}
+
+Index ByteCode::size(void) const
+{
+    return static_cast<Index>(code_.size());
+}
+
+unsigned int ByteCode::getMaxStackDepth(void) const
+{
+    return maxDepth_;
+}
+
+// number of values left on the stack at the end of the program
+unsigned int ByteCode::getStackDepth(void) const
+{
+    return depth_;
+}
+
+unsigned int ByteCode::getNVariable(void) const
+{
+    return nVar_;
+}
+
+unsigned int ByteCode::getNFunction(void) const
+{
+    return nFunc_;
+}
+
+// assembly ////////////////////////////////////////////////////////////////////
+void ByteCode::push(const OpCode code, const unsigned int arg,
+                    const unsigned int nArg)
+{
+    int delta = 0;
+
+    switch (code)
+    {
+        case OpCode::pushCst:
+            delta = 1;
+            break;
+        case OpCode::pushVar:
+            delta = 1;
+            nVar_ = max(nVar_, arg + 1);
+            break;
+        case OpCode::pop:
+            delta = -1;
+            nVar_ = max(nVar_, arg + 1);
+            break;
+        case OpCode::drop:
+            delta = -1;
+            break;
+        case OpCode::store:
+            nVar_ = max(nVar_, arg + 1);
+            break;
+        case OpCode::dup:
+            delta = 1;
+            break;
+        case OpCode::call:
+            delta = 1 - static_cast<int>(nArg);
+            nFunc_ = max(nFunc_, arg + 1);
+            break;
+        case OpCode::intrinsic1:
+            break;
+        case OpCode::intrinsic2:
+            delta = -1;
+            break;
+        case OpCode::neg:
+            break;
+        case OpCode::add:
+        case OpCode::sub:
+        case OpCode::mul:
+        case OpCode::div:
+        case OpCode::pow:
+            delta = -1;
+            break;
+    }
+    if (static_cast<int>(depth_) + delta < 0)
+    {
+        LATAN_ERROR(Compilation, "byte code stack underflow");
+    }
+    depth_    = static_cast<unsigned int>(static_cast<int>(depth_) + delta);
+    maxDepth_ = max(maxDepth_, depth_);
+    code_.push_back({code, static_cast<unsigned short>(nArg), arg});
+}
+
+void ByteCode::pushConstant(const double val)
+{
+    push(OpCode::pushCst, static_cast<unsigned int>(constant_.size()));
+    constant_.push_back(val);
+}
+
+void ByteCode::clear(void)
+{
+    code_.clear();
+    constant_.clear();
+    depth_    = 0;
+    maxDepth_ = 0;
+    nVar_     = 0;
+    nFunc_    = 0;
+}
+
 /******************************************************************************
  *                            Instruction set                                 *
  ******************************************************************************/
@@ -254,6 +409,19 @@ void Push::operator()(RunContext &context) const
     context.incrementInsIndex();
 }
 
+// Push assembly ///////////////////////////////////////////////////////////////
+void Push::assemble(ByteCode &code) const
+{
+    if (type_ == ArgType::Constant)
+    {
+        code.pushConstant(val_);
+    }
+    else
+    {
+        code.push(ByteCode::OpCode::pushVar, address_);
+    }
+}
+
 // Push print //////////////////////////////////////////////////////////////////
 void Push::print(ostream &out) const
 {
@@ -285,6 +453,19 @@ void Pop::operator()(RunContext &context) const
     context.incrementInsIndex();
 }
 
+// Pop assembly ////////////////////////////////////////////////////////////////
+void Pop::assemble(ByteCode &code) const
+{
+    if (!name_.empty())
+    {
+        code.push(ByteCode::OpCode::pop, address_);
+    }
+    else
+    {
+        code.push(ByteCode::OpCode::drop);
+    }
+}
+
 // Pop print ///////////////////////////////////////////////////////////////////
 void Pop::print(ostream &out) const
 {
@@ -307,6 +488,15 @@ void Store::operator()(RunContext &context) const
     context.incrementInsIndex();
 }
 
+// Store assembly //////////////////////////////////////////////////////////////
+void Store::assemble(ByteCode &code) const
+{
+    if (!name_.empty())
+    {
+        code.push(ByteCode::OpCode::store, address_);
+    }
+}
+
 // Store print /////////////////////////////////////////////////////////////////
 void Store::print(ostream &out) const
 {
@@ -314,11 +504,19 @@ void Store::print(ostream &out) const
 }
 
 // Call constructor ////////////////////////////////////////////////////////////
-Call::Call(const unsigned int address, const string &name)
+Call::Call(const unsigned int address, const string &name,
+           const unsigned int nArg)
 : address_(address)
+, nArg_(nArg)
 , name_(name)
 {}
 
+// Call access /////////////////////////////////////////////////////////////////
+const string & Call::getName(void) const
+{
+    return name_;
+}
+
 // Call execution //////////////////////////////////////////////////////////////
 void Call::operator()(RunContext &context) const
 {
@@ -326,14 +524,139 @@ void Call::operator()(RunContext &context) const
     context.incrementInsIndex();
 }
 
+// Call assembly ///////////////////////////////////////////////////////////////
+void Call::assemble(ByteCode &code) const
+{
+    code.push(ByteCode::OpCode::call, address_, nArg_);
+}
+
 // Call print //////////////////////////////////////////////////////////////////
 void Call::print(ostream &out) const
 {
     out << CODE_MOD << "call" << CODE_MOD << name_ << " @f" << address_;
 }
 
+// Intrinsic table /////////////////////////////////////////////////////////////
+// builtin functions executed by the virtual machine as direct calls to the C
+// functions, the index in this table is the operand of the intrinsic opcodes
+struct IntrinsicFunc
+{
+    const char           *name;
+    const DoubleFunction *builtin;
+    unsigned int         nArg;
+    double               (*f1)(const double);
+    double               (*f2)(const double, const double);
+};
+
+#define INTRINSIC1(func)\
+{#func, &STDMATH_NAMESPACE::func, 1,\
+ [](const double x) {return std::func(x);}, nullptr}
+#define INTRINSIC2(func)\
+{#func, &STDMATH_NAMESPACE::func, 2,\
+ nullptr, [](const double x, const double y) {return std::func(x, y);}}
+
+static const IntrinsicFunc intrinsic[] =
+{
+    INTRINSIC1(cos),       INTRINSIC1(sin),   INTRINSIC1(tan),
+    INTRINSIC1(acos),      INTRINSIC1(asin),  INTRINSIC1(atan),
+    INTRINSIC2(atan2),     INTRINSIC1(cosh),  INTRINSIC1(sinh),
+    INTRINSIC1(tanh),      INTRINSIC1(acosh), INTRINSIC1(asinh),
+    INTRINSIC1(atanh),     INTRINSIC1(exp),   INTRINSIC1(log),
+    INTRINSIC1(log10),     INTRINSIC1(exp2),  INTRINSIC1(expm1),
+    INTRINSIC1(log1p),     INTRINSIC1(log2),  INTRINSIC2(pow),
+    INTRINSIC1(sqrt),      INTRINSIC1(cbrt),  INTRINSIC2(hypot),
+    INTRINSIC1(erf),       INTRINSIC1(erfc),  INTRINSIC1(tgamma),
+    INTRINSIC1(lgamma),    INTRINSIC1(ceil),  INTRINSIC1(floor),
+    INTRINSIC2(fmod),      INTRINSIC1(trunc), INTRINSIC1(round),
+    INTRINSIC1(rint),      INTRINSIC1(nearbyint),
+    INTRINSIC2(remainder), INTRINSIC2(fdim),  INTRINSIC2(fmax),
+    INTRINSIC2(fmin),      INTRINSIC1(fabs)
+};
+
+#define N_INTRINSIC (sizeof(intrinsic)/sizeof(intrinsic[0]))
+
+// Intrinsic constructor ///////////////////////////////////////////////////////
+Intrinsic::Intrinsic(const unsigned int index)
+: index_(index)
+{
+    if (index_ >= N_INTRINSIC)
+    {
+        LATAN_ERROR(Range, "intrinsic index " + strFrom(index_)
+                    + " out of range");
+    }
+}
+
+// Intrinsic index /////////////////////////////////////////////////////////////
+int Intrinsic::getIndex(const DoubleFunction *f)
+{
+    for (unsigned int i = 0; i < N_INTRINSIC; ++i)
+    {
+        if (f and (f == intrinsic[i].builtin))
+        {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+// Intrinsic access ////////////////////////////////////////////////////////////
+string Intrinsic::getName(void) const
+{
+    return intrinsic[index_].name;
+}
+
+// Intrinsic execution /////////////////////////////////////////////////////////
+void Intrinsic::operator()(RunContext &context) const
+{
+    const IntrinsicFunc &in = intrinsic[index_];
+    double              x[2];
+
+    for (unsigned int i = 0; i < in.nArg; ++i)
+    {
+        x[in.nArg - 1 - i] = context.stack().top();
+        context.stack().pop();
+    }
+    context.stack().push((in.nArg == 1) ? in.f1(x[0]) : in.f2(x[0], x[1]));
+    context.incrementInsIndex();
+}
+
+// Intrinsic assembly //////////////////////////////////////////////////////////
+void Intrinsic::assemble(ByteCode &code) const
+{
+    code.push((intrinsic[index_].nArg == 1) ? ByteCode::OpCode::intrinsic1
+                                            : ByteCode::OpCode::intrinsic2,
+              index_, intrinsic[index_].nArg);
+}
+
+// Intrinsic print /////////////////////////////////////////////////////////////
+void Intrinsic::print(ostream &out) const
+{
+    out << CODE_MOD << "calli" << CODE_MOD << intrinsic[index_].name
+        << " @i" << index_;
+}
+
+// Dup execution ///////////////////////////////////////////////////////////////
+void Dup::operator()(RunContext &context) const
+{
+    context.stack().push(context.stack().top());
+    context.incrementInsIndex();
+}
+
+// Dup assembly ////////////////////////////////////////////////////////////////
+void Dup::assemble(ByteCode &code) const
+{
+    code.push(ByteCode::OpCode::dup);
+}
+
+// Dup print ///////////////////////////////////////////////////////////////////
+void Dup::print(ostream &out) const
+{
+    out << CODE_MOD << "dup";
+}
+
 // Math operations /////////////////////////////////////////////////////////////
-#define DEF_OP(name, nArg, exp, insName)\
+#define DEF_OP(name, nArg, exp, insName, opCode)\
 void name::operator()(RunContext &context) const\
 {\
     double x[nArg];\
@@ -345,17 +668,21 @@ void name::operator()(RunContext &context) const\
     context.stack().push(exp);\
     context.incrementInsIndex();\
 }\
+void name::assemble(ByteCode &code) const\
+{\
+    code.push(ByteCode::OpCode::opCode);\
+}\
 void name::print(ostream &out) const\
 {\
     out << CODE_MOD << insName;\
 }
 
-DEF_OP(Neg, 1, -x[0],          "neg")
-DEF_OP(Add, 2, x[0] + x[1],    "add")
-DEF_OP(Sub, 2, x[0] - x[1],    "sub")
-DEF_OP(Mul, 2, x[0]*x[1],      "mul")
-DEF_OP(Div, 2, x[0]/x[1],      "div")
-DEF_OP(Pow, 2, pow(x[0],x[1]), "pow")
+DEF_OP(Neg, 1, -x[0],          "neg", neg)
+DEF_OP(Add, 2, x[0] + x[1],    "add", add)
+DEF_OP(Sub, 2, x[0] - x[1],    "sub", sub)
+DEF_OP(Mul, 2, x[0]*x[1],      "mul", mul)
+DEF_OP(Div, 2, x[0]/x[1],      "div", div)
+DEF_OP(Pow, 2, pow(x[0],x[1]), "pow", pow)
 
 /******************************************************************************
  *                        ExprNode implementation                             *
@@ -408,12 +735,69 @@ void ExprNode::pushArg(ExprNode *node)
     }
 }
 
+void ExprNode::setArg(const Index i, ExprNode *node)
+{
+    if (node)
+    {
+        node->parent_ = this;
+    }
+    arg_[i].reset(node);
+}
+
+ExprNode * ExprNode::releaseArg(const Index i)
+{
+    ExprNode *node = arg_[i].release();
+
+    if (node)
+    {
+        node->parent_ = nullptr;
+    }
+
+    return node;
+}
+
 // ExprNode operators //////////////////////////////////////////////////////////
 const ExprNode &ExprNode::operator[](const Index i) const
 {
     return *arg_[i];
 }
 
+// ExprNode copy ///////////////////////////////////////////////////////////////
+void ExprNode::cloneArg(ExprNode &node) const
+{
+    for (auto &a: arg_)
+    {
+        node.pushArg(a->clone());
+    }
+}
+
+#define DEF_CLONE(name)\
+ExprNode * name::clone(void) const\
+{\
+    name *node = new name(getName());\
+    \
+    cloneArg(*node);\
+    \
+    return node;\
+}
+
+DEF_CLONE(VarNode)
+DEF_CLONE(SemicolonNode)
+DEF_CLONE(AssignNode)
+DEF_CLONE(MathOpNode)
+DEF_CLONE(IntPowNode)
+DEF_CLONE(FuncNode)
+DEF_CLONE(ReturnNode)
+
+ExprNode * CstNode::clone(void) const
+{
+    CstNode *node = new CstNode(val_);
+
+    node->setName(getName());
+
+    return node;
+}
+
 ostream &Latan::operator<<(ostream &out, const ExprNode &n)
 {
     Index level = n.getLevel();
@@ -442,78 +826,311 @@ ostream &Latan::operator<<(ostream &out, const ExprNode &n)
     return out;
 }
 
-#define PUSH_INS(program, type, ...)\
-program.push_back(unique_ptr<type>(new type(__VA_ARGS__)))
-#define GET_ADDRESS(address, table, name)\
-try\
-{\
-    address = (table).at(name);\
-}\
-catch (out_of_range)\
-{\
-    address         = (table).size();\
-    (table)[(name)] = address;\
-}\
+// ExprNode to program code ///////////////////////////////////////////////////
+#define PREC_ADD   1
+#define PREC_MUL   2
+#define PREC_UNARY 3
+#define PREC_POW   4
+#define PREC_ATOM  5
 
-// VarNode compile /////////////////////////////////////////////////////////////
-void VarNode::compile(Program &program, RunContext &context) const
+static int precedence(const ExprNode &n)
 {
-    PUSH_INS(program, Push, context.getVariableAddress(getName()), getName());
-}
+    const CstNode *c = dynamic_cast<const CstNode *>(&n);
 
-// CstNode compile /////////////////////////////////////////////////////////////
-void CstNode::compile(Program &program, RunContext &context __dumb) const
-{
-    PUSH_INS(program, Push, strTo<double>(getName()));
+    if (c)
+    {
+        return (!isnan(c->getValue()) and signbit(c->getValue())) ? PREC_UNARY
+                                                                  : PREC_ATOM;
+    }
+    else if (isDerivedFrom<MathOpNode>(&n))
+    {
+        if (n.getNArg() == 1)
+        {
+            return PREC_UNARY;
+        }
+        else if ((n.getName() == "+") or (n.getName() == "-"))
+        {
+            return PREC_ADD;
+        }
+        else if ((n.getName() == "*") or (n.getName() == "/"))
+        {
+            return PREC_MUL;
+        }
+        else
+        {
+            return PREC_POW;
+        }
+    }
+    else
+    {
+        return PREC_ATOM;
+    }
 }
 
-// SemicolonNode compile ///////////////////////////////////////////////////////
-void SemicolonNode::compile(Program &program, RunContext &context) const
+// shortest decimal representation which reads back to the same value
+static string cstCode(const double val)
 {
-    auto &n = *this;
-    
-    for (Index i = 0; i < getNArg(); ++i)
+    double a = fabs(val);
+    string str;
+
+    if (isnan(val))
     {
-        bool isAssign     = isDerivedFrom<AssignNode>(&n[i]);
-        bool isSemiColumn = isDerivedFrom<SemicolonNode>(&n[i]);
-        bool isKeyword    = isDerivedFrom<KeywordNode>(&n[i]);
-        
-        if (isAssign or isSemiColumn or isKeyword)
+        return "(0/0)";
+    }
+    else if (isinf(val))
+    {
+        str = "inf";
+    }
+    else
+    {
+        for (int prec = 15; prec <= 17; ++prec)
         {
-            n[i].compile(program, context);
+            ostringstream buf;
+
+            buf << setprecision(prec) << a;
+            str = buf.str();
+            if (strTo<double>(str) == a)
+            {
+                break;
+            }
         }
     }
+
+    return signbit(val) ? "-" + str : str;
 }
 
-// AssignNode compile //////////////////////////////////////////////////////////
-void AssignNode::compile(Program &program, RunContext &context) const
+static void exprCode(ostream &out, const ExprNode &n);
+
+static void argCode(ostream &out, const ExprNode &n, const bool paren)
 {
-    auto &n = *this;
-    
-    if (isDerivedFrom<VarNode>(&n[0]))
+    if (paren)
     {
-        bool hasSemicolonParent = isDerivedFrom<SemicolonNode>(getParent());
-        unsigned int address;
-        
-        n[1].compile(program, context);
-        address = context.addVariable(n[0].getName());
-        if (hasSemicolonParent)
+        out << "(";
+        exprCode(out, n);
+        out << ")";
+    }
+    else
+    {
+        exprCode(out, n);
+    }
+}
+
+// the parser operators are all left-associative, the right operand is put in
+// parentheses at equal precedence to keep the evaluation order
+static void exprCode(ostream &out, const ExprNode &n)
+{
+    const CstNode *c = dynamic_cast<const CstNode *>(&n);
+
+    if (c)
+    {
+        out << cstCode(c->getValue());
+    }
+    else if (isDerivedFrom<VarNode>(&n))
+    {
+        out << n.getName();
+    }
+    else if (isDerivedFrom<MathOpNode>(&n))
+    {
+        int prec = precedence(n);
+
+        if (n.getNArg() == 1)
         {
-            PUSH_INS(program, Pop, address, n[0].getName());
+            out << n.getName();
+            argCode(out, n[0], precedence(n[0]) <= prec);
         }
         else
         {
-            PUSH_INS(program, Store, address, n[0].getName());
+            argCode(out, n[0], precedence(n[0]) < prec);
+            out << ((prec == PREC_POW) ? n.getName() : " " + n.getName() + " ");
+            argCode(out, n[1], (precedence(n[1]) <= prec)
+                               or (precedence(n[1]) == PREC_UNARY));
+        }
+    }
+    else if (isDerivedFrom<FuncNode>(&n))
+    {
+        out << n.getName() << "(";
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            out << ((i > 0) ? ", " : "");
+            exprCode(out, n[i]);
         }
+        out << ")";
     }
     else
     {
-        LATAN_ERROR(Compilation, "invalid LHS for '='");
+        LATAN_ERROR(Implementation, "cannot convert node '" + n.getName()
+                    + "' to an expression");
     }
 }
 
-// MathOpNode compile //////////////////////////////////////////////////////////
-#define IFNODE(name, nArg) if ((n.getName() == (name)) and (n.getNArg() == nArg))
+static void stmtCode(ostream &out, const ExprNode &n)
+{
+    if (isDerivedFrom<SemicolonNode>(&n))
+    {
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            stmtCode(out, n[i]);
+        }
+    }
+    else if (isDerivedFrom<AssignNode>(&n))
+    {
+        out << (out.tellp() > 0 ? " " : "") << n[0].getName() << " = ";
+        exprCode(out, n[1]);
+        out << ";";
+    }
+    else if (isDerivedFrom<ReturnNode>(&n))
+    {
+        out << (out.tellp() > 0 ? " " : "") << "return ";
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            out << ((i > 0) ? ", " : "");
+            exprCode(out, n[i]);
+        }
+        out << ";";
+    }
+}
+
+string Latan::toCode(const ExprNode &ast)
+{
+    ostringstream out;
+
+    if (isDerivedFrom<SemicolonNode>(&ast) or isDerivedFrom<AssignNode>(&ast)
+        or isDerivedFrom<KeywordNode>(&ast))
+    {
+        stmtCode(out, ast);
+    }
+    else
+    {
+        exprCode(out, ast);
+    }
+
+    return out.str();
+}
+
+// ExprNode variable names /////////////////////////////////////////////////////
+void Latan::getVariableNames(set<string> &names, const ExprNode &ast)
+{
+    if (isDerivedFrom<VarNode>(&ast))
+    {
+        names.insert(ast.getName());
+    }
+    for (Index i = 0; i < ast.getNArg(); ++i)
+    {
+        getVariableNames(names, ast[i]);
+    }
+}
+
+string Latan::uniquePrefix(const set<string> &names, const string &base)
+{
+    string prefix = base;
+    bool   collision;
+
+    do
+    {
+        collision = false;
+        for (auto &name: names)
+        {
+            if (name.compare(0, prefix.size(), prefix) == 0)
+            {
+                collision = true;
+                prefix    = "_" + prefix;
+                break;
+            }
+        }
+    } while (collision);
+
+    return prefix;
+}
+
+#define PUSH_INS(program, type, ...)\
+program.push_back(unique_ptr<type>(new type(__VA_ARGS__)))
+#define GET_ADDRESS(address, table, name)\
+try\
+{\
+    address = (table).at(name);\
+}\
+catch (out_of_range)\
+{\
+    address         = (table).size();\
+    (table)[(name)] = address;\
+}\
+
+// VarNode compile /////////////////////////////////////////////////////////////
+void VarNode::compile(Program &program, RunContext &context) const
+{
+    PUSH_INS(program, Push, context.getVariableAddress(getName()), getName());
+}
+
+// CstNode constructors ////////////////////////////////////////////////////////
+CstNode::CstNode(const string &name)
+: ExprNode(name)
+, val_(strTo<double>(name))
+{}
+
+CstNode::CstNode(const double val)
+: ExprNode(strFrom(val))
+, val_(val)
+{}
+
+// CstNode access //////////////////////////////////////////////////////////////
+double CstNode::getValue(void) const
+{
+    return val_;
+}
+
+// CstNode compile /////////////////////////////////////////////////////////////
+void CstNode::compile(Program &program, RunContext &context __dumb) const
+{
+    PUSH_INS(program, Push, val_);
+}
+
+// SemicolonNode compile ///////////////////////////////////////////////////////
+void SemicolonNode::compile(Program &program, RunContext &context) const
+{
+    auto &n = *this;
+    
+    for (Index i = 0; i < getNArg(); ++i)
+    {
+        bool isAssign     = isDerivedFrom<AssignNode>(&n[i]);
+        bool isSemiColumn = isDerivedFrom<SemicolonNode>(&n[i]);
+        bool isKeyword    = isDerivedFrom<KeywordNode>(&n[i]);
+        
+        if (isAssign or isSemiColumn or isKeyword)
+        {
+            n[i].compile(program, context);
+        }
+    }
+}
+
+// AssignNode compile //////////////////////////////////////////////////////////
+void AssignNode::compile(Program &program, RunContext &context) const
+{
+    auto &n = *this;
+    
+    if (isDerivedFrom<VarNode>(&n[0]))
+    {
+        bool hasSemicolonParent = isDerivedFrom<SemicolonNode>(getParent());
+        unsigned int address;
+        
+        n[1].compile(program, context);
+        address = context.addVariable(n[0].getName());
+        if (hasSemicolonParent)
+        {
+            PUSH_INS(program, Pop, address, n[0].getName());
+        }
+        else
+        {
+            PUSH_INS(program, Store, address, n[0].getName());
+        }
+    }
+    else
+    {
+        LATAN_ERROR(Compilation, "invalid LHS for '='");
+    }
+}
+
+// MathOpNode compile //////////////////////////////////////////////////////////
+#define IFNODE(name, nArg) if ((n.getName() == (name)) and (n.getNArg() == nArg))
 #define ELIFNODE(name, nArg) else IFNODE(name, nArg)
 #define ELSE else
 
@@ -534,16 +1151,71 @@ void MathOpNode::compile(Program &program, RunContext &context) const
     ELSE LATAN_ERROR(Compilation, "unknown operator '" + getName() + "'");
 }
 
+// IntPowNode compile //////////////////////////////////////////////////////////
+// x^n with a constant integer n > 1 is computed with left-to-right binary
+// exponentiation: one copy of x is kept on the stack for each set bit of n
+// below the leading one, the top of the stack is squared for each bit and
+// multiplied by one of the copies for each set bit
+void IntPowNode::compile(Program &program, RunContext &context) const
+{
+    auto          &n = *this;
+    const CstNode *e = dynamic_cast<const CstNode *>(&n[1]);
+    unsigned int  nPow, bit;
+
+    if (!e or (e->getValue() < 2.) or (e->getValue() != floor(e->getValue())))
+    {
+        LATAN_ERROR(Compilation, "integer power node with invalid exponent");
+    }
+    nPow = static_cast<unsigned int>(e->getValue());
+    for (bit = 1; (bit << 1) <= nPow; bit <<= 1);
+    n[0].compile(program, context);
+    for (unsigned int b = bit >> 1; b > 0; b >>= 1)
+    {
+        if (nPow & b)
+        {
+            PUSH_INS(program, Dup,);
+        }
+    }
+    for (bit >>= 1; bit > 0; bit >>= 1)
+    {
+        PUSH_INS(program, Dup,);
+        PUSH_INS(program, Mul,);
+        if (nPow & bit)
+        {
+            PUSH_INS(program, Mul,);
+        }
+    }
+}
+
 // FuncNode compile ////////////////////////////////////////////////////////////
 void FuncNode::compile(Program &program, RunContext &context) const
 {
-    auto &n = *this;
+    auto           &n      = *this;
+    unsigned int   address = context.getFunctionAddress(getName());
+    DoubleFunction *f      = context.getFunction(address);
     
+    if (f and (f->getNArg() != n.getNArg()))
+    {
+        LATAN_ERROR(Compilation, "function '" + getName() + "' expects "
+                    + strFrom(f->getNArg()) + " argument(s) (got "
+                    + strFrom(n.getNArg()) + ")");
+    }
     for (Index i = 0; i < n.getNArg(); ++i)
     {
         n[i].compile(program, context);
     }
-    PUSH_INS(program, Call, context.getFunctionAddress(getName()), getName());
+    // builtins are bound at compile time and called directly by the VM
+    int index = Intrinsic::getIndex(f);
+
+    if (index >= 0)
+    {
+        PUSH_INS(program, Intrinsic, static_cast<unsigned int>(index));
+    }
+    else
+    {
+        PUSH_INS(program, Call, address, getName(),
+                 static_cast<unsigned int>(n.getNArg()));
+    }
 }
 
 // ReturnNode compile ////////////////////////////////////////////////////////////
@@ -551,7 +1223,10 @@ void ReturnNode::compile(Program &program, RunContext &context) const
 {
     auto &n = *this;
     
-    n[0].compile(program, context);
+    for (Index i = 0; i < n.getNArg(); ++i)
+    {
+        n[i].compile(program, context);
+    }
     program.push_back(nullptr);
 }
 
@@ -590,6 +1265,26 @@ const ExprNode * MathInterpreter::getAST(void) const
     return root_.get();
 }
 
+const ExprNode * MathInterpreter::getOptimizedAST(void) const
+{
+    return optRoot_.get();
+}
+
+const ByteCode & MathInterpreter::getByteCode(void) const
+{
+    return byteCode_;
+}
+
+Index MathInterpreter::getNInstruction(void) const
+{
+    return static_cast<Index>(program_.size());
+}
+
+Index MathInterpreter::getNOutput(void) const
+{
+    return byteCode_.getStackDepth();
+}
+
 void MathInterpreter::push(const Instruction *i)
 {
     program_.push_back(unique_ptr<const Instruction>(i));
@@ -606,16 +1301,34 @@ void MathInterpreter::setCode(const std::string &code)
     codeName_ = "<string>";
     state_.reset(new MathParserState(code_.get(), &codeName_, &root_));
     program_.clear();
+    byteCode_.clear();
     status_   = Status::initialised;
 }
 
+// optimization ////////////////////////////////////////////////////////////////
+bool MathInterpreter::getOptimization(void) const
+{
+    return optimize_;
+}
+
+void MathInterpreter::useOptimization(const bool use)
+{
+    if (use != optimize_)
+    {
+        optimize_  = use;
+        status_   -= status_ & Status::compiled;
+    }
+}
+
 void MathInterpreter::reset(void)
 {
     code_.reset();
     codeName_ = "<no_code>";
     state_.reset();
     root_.reset();
+    optRoot_.reset();
     program_.clear();
+    byteCode_.clear();
     status_ = 0;
 }
 
@@ -626,7 +1339,12 @@ int _math_parse(MathInterpreter::MathParserState *state);
 
 void MathInterpreter::parse(void)
 {
-    _math_parse(state_.get());
+    if (!(status_ & Status::parsed))
+    {
+        _math_parse(state_.get());
+        status_ |= Status::parsed;
+        status_ -= status_ & Status::compiled;
+    }
 }
 
 // interpreter /////////////////////////////////////////////////////////////////
@@ -675,71 +1393,1127 @@ ADD_FUNC(context, fmax);\
 ADD_FUNC(context, fmin);\
 ADD_FUNC(context, fabs);
 
-void MathInterpreter::compile(RunContext &context)
+// AST optimization ////////////////////////////////////////////////////////////
+// largest integer exponent expanded into a multiplication chain
+#define MAX_INT_POW 8
+
+// builtin functions are pure and can be evaluated at compile time
+static bool isStdMathFunction(const DoubleFunction *f)
 {
-    bool gotReturn = false;
-    
-    if (!(status_ & Status::parsed))
+    return (Intrinsic::getIndex(f) >= 0);
+}
+
+static bool isConstant(const ExprNode &node, const double val)
+{
+    auto *c = dynamic_cast<const CstNode *>(&node);
+
+    return c and (c->getValue() == val);
+}
+
+static unique_ptr<ExprNode> makeNeg(unique_ptr<ExprNode> node)
+{
+    auto *c = dynamic_cast<const CstNode *>(node.get());
+
+    if (c)
     {
-        parse();
-        status_ |= Status::parsed;
-        status_ -= status_ & Status::compiled;
+        return unique_ptr<ExprNode>(new CstNode(-c->getValue()));
     }
-    if (!(status_ & Status::compiled))
+    else if ((typeid(*node) == typeid(MathOpNode)) and (node->getName() == "-")
+             and (node->getNArg() == 1))
     {
-        if (root_)
+        return unique_ptr<ExprNode>(node->releaseArg(0));
+    }
+    else
+    {
+        unique_ptr<ExprNode> neg(new MathOpNode("-"));
+
+        neg->pushArg(node.release());
+
+        return neg;
+    }
+}
+
+static unique_ptr<ExprNode> optimizeMathOp(unique_ptr<ExprNode> node)
+{
+    auto       &n    = *node;
+    const auto &name = n.getName();
+
+    if (n.getNArg() == 1)
+    {
+        IFNODE("-", 1)
         {
-            context.addVariable("pi",  Math::pi);
-            context.addVariable("inf", Math::inf);
-            ADD_STDMATH_FUNCS(context);
-            root_->compile(program_, context);
-            for (unsigned int i = 0; i < program_.size(); ++i)
+            return makeNeg(unique_ptr<ExprNode>(n.releaseArg(0)));
+        }
+    }
+    else if (n.getNArg() == 2)
+    {
+        auto *c0 = dynamic_cast<const CstNode *>(&n[0]);
+        auto *c1 = dynamic_cast<const CstNode *>(&n[1]);
+
+        // constant folding
+        if (c0 and c1)
+        {
+            double x = c0->getValue(), y = c1->getValue();
+
+            IFNODE("+", 2)   return unique_ptr<ExprNode>(new CstNode(x + y));
+            ELIFNODE("-", 2) return unique_ptr<ExprNode>(new CstNode(x - y));
+            ELIFNODE("*", 2) return unique_ptr<ExprNode>(new CstNode(x*y));
+            ELIFNODE("/", 2) return unique_ptr<ExprNode>(new CstNode(x/y));
+            ELIFNODE("^", 2)
             {
-                if (!program_[i])
-                {
-                    gotReturn = true;
-                    program_.resize(i);
-                    program_.shrink_to_fit();
-                    break;
-                }
+                return unique_ptr<ExprNode>(new CstNode(pow(x, y)));
             }
         }
-        if (!root_ or !gotReturn)
+        // algebraic identities (x*0 is not simplified since x can be inf or
+        // nan)
+        if (((name == "+") and isConstant(n[1], 0.))
+            or ((name == "-") and isConstant(n[1], 0.))
+            or ((name == "*") and isConstant(n[1], 1.))
+            or ((name == "/") and isConstant(n[1], 1.))
+            or ((name == "^") and isConstant(n[1], 1.)))
         {
-            LATAN_ERROR(Syntax, "expected 'return' in program '" + codeName_
-                        + "'");
+            return unique_ptr<ExprNode>(n.releaseArg(0));
         }
-        status_ |= Status::compiled;
-    }
-}
+        if (((name == "+") and isConstant(n[0], 0.))
+            or ((name == "*") and isConstant(n[0], 1.)))
+        {
+            return unique_ptr<ExprNode>(n.releaseArg(1));
+        }
+        if (((name == "-") and isConstant(n[0], 0.))
+            or ((name == "*") and isConstant(n[0], -1.)))
+        {
+            return makeNeg(unique_ptr<ExprNode>(n.releaseArg(1)));
+        }
+        if (((name == "*") and isConstant(n[1], -1.))
+            or ((name == "/") and isConstant(n[1], -1.)))
+        {
+            return makeNeg(unique_ptr<ExprNode>(n.releaseArg(0)));
+        }
+        // small integer powers
+        if ((name == "^") and c1)
+        {
+            double e = c1->getValue();
 
+            if (e == 0.)
+            {
+                return unique_ptr<ExprNode>(new CstNode(1.));
+            }
+            else if ((e == floor(e)) and (fabs(e) <= MAX_INT_POW))
+            {
+                unique_ptr<ExprNode> res(n.releaseArg(0));
 
-// execution ///////////////////////////////////////////////////////////////////
-void MathInterpreter::operator()(RunContext &context)
-{
-    if (!(status_ & Status::compiled))
-    {
-        compile(context);
+                if (fabs(e) > 1.)
+                {
+                    unique_ptr<ExprNode> p(new IntPowNode("^"));
+
+                    p->pushArg(res.release());
+                    p->pushArg(new CstNode(fabs(e)));
+                    res = move(p);
+                }
+                if (e < 0.)
+                {
+                    unique_ptr<ExprNode> inv(new MathOpNode("/"));
+
+                    inv->pushArg(new CstNode(1.));
+                    inv->pushArg(res.release());
+                    res = move(inv);
+                }
+
+                return res;
+            }
+        }
     }
-    execute(context);
+
+    return node;
 }
 
-void MathInterpreter::execute(RunContext &context) const
+static unique_ptr<ExprNode> optimizeNode(unique_ptr<ExprNode> node,
+                                         const RunContext &context)
 {
-    context.setInsIndex(0);
-    while (context.getInsIndex() != program_.size())
+    auto &n = *node;
+
+    // post-order traversal: arguments are simplified first
+    for (Index i = 0; i < n.getNArg(); ++i)
     {
-        (*(program_[context.getInsIndex()]))(context);
-    }
-}
+        unique_ptr<ExprNode> arg(n.releaseArg(i));
 
-// IO //////////////////////////////////////////////////////////////////////////
-ostream &Latan::operator<<(ostream &out, const MathInterpreter &program)
+        n.setArg(i, optimizeNode(move(arg), context).release());
+    }
+    if (typeid(n) == typeid(MathOpNode))
+    {
+        return optimizeMathOp(move(node));
+    }
+    else if (isDerivedFrom<FuncNode>(&n))
+    {
+        auto          &table = context.getFunctionTable();
+        auto          it     = table.find(n.getName());
+        vector<double> arg(n.getNArg());
+
+        if ((it == table.end())
+            or !isStdMathFunction(context.getFunction(it->second))
+            or (context.getFunction(it->second)->getNArg() != n.getNArg()))
+        {
+            return node;
+        }
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            auto *c = dynamic_cast<const CstNode *>(&n[i]);
+
+            if (!c)
+            {
+                return node;
+            }
+            arg[i] = c->getValue();
+        }
+
+        return unique_ptr<ExprNode>(
+            new CstNode((*context.getFunction(it->second))(arg)));
+    }
+
+    return node;
+}
+
+void MathInterpreter::compile(RunContext &context)
+{
+    bool gotReturn = false;
+    
+    parse();
+    if (!(status_ & Status::compiled))
+    {
+        program_.clear();
+        optRoot_.reset();
+        if (root_)
+        {
+            const ExprNode *root = root_.get();
+
+            context.addVariable("pi",  Math::pi);
+            context.addVariable("inf", Math::inf);
+            ADD_STDMATH_FUNCS(context);
+            if (optimize_)
+            {
+                optRoot_ = optimizeNode(unique_ptr<ExprNode>(root_->clone()),
+                                        context);
+                root     = optRoot_.get();
+            }
+            root->compile(program_, context);
+            for (unsigned int i = 0; i < program_.size(); ++i)
+            {
+                if (!program_[i])
+                {
+                    gotReturn = true;
+                    program_.resize(i);
+                    program_.shrink_to_fit();
+                    break;
+                }
+            }
+        }
+        if (!root_ or !gotReturn)
+        {
+            LATAN_ERROR(Syntax, "expected 'return' in program '" + codeName_
+                        + "'");
+        }
+        byteCode_.clear();
+        opInstruction_.clear();
+        for (unsigned int i = 0; i < program_.size(); ++i)
+        {
+            program_[i]->assemble(byteCode_);
+            opInstruction_.resize(byteCode_.size(), i);
+        }
+        resetProfile();
+        context.vmStack_.resize(max(context.vmStack_.size(),
+            static_cast<size_t>(byteCode_.getMaxStackDepth())));
+        status_ |= Status::compiled;
+    }
+}
+
+
+// execution ///////////////////////////////////////////////////////////////////
+void MathInterpreter::operator()(RunContext &context)
 {
-    for (unsigned int i = 0; i < program.program_.size(); ++i)
+    context.stack().push(evaluate(context));
+}
+
+double MathInterpreter::evaluate(RunContext &context)
+{
+    if (!(status_ & Status::compiled))
     {
-        out << *(program.program_[i]) << endl;
+        compile(context);
     }
     
+    return execute(context);
+}
+
+void MathInterpreter::evaluate(double *res, RunContext &context,
+                               const Index nLane,
+                               const vector<unsigned int> &laneAddress,
+                               const double *laneData)
+{
+    if (!(status_ & Status::compiled))
+    {
+        compile(context);
+    }
+    execute(res, context, nLane, laneAddress, laneData);
+}
+
+double MathInterpreter::execute(RunContext &context) const
+{
+    return run(context)[byteCode_.getStackDepth() - 1];
+}
+
+double MathInterpreter::execute(RunContext &context, const Index output) const
+{
+    if ((output < 0) or (output >= getNOutput()))
+    {
+        LATAN_ERROR(Range, "output index out of range");
+    }
+
+    return run(context)[output];
+}
+
+void MathInterpreter::execute(double *res, RunContext &context) const
+{
+    const double *out = run(context);
+
+    copy(out, out + byteCode_.getStackDepth(), res);
+}
+
+// cost in nanoseconds of a clock reading, subtracted from the profiled times
+static double clockOverhead(void)
+{
+    typedef chrono::steady_clock Clock;
+
+    static const double overhead = []()
+    {
+        double best = numeric_limits<double>::max();
+
+        for (unsigned int i = 0; i < 1000; ++i)
+        {
+            auto start = Clock::now(), end = Clock::now();
+
+            best = min(best, chrono::duration<double, nano>(end - start)
+                             .count());
+        }
+
+        return best;
+    }();
+
+    return overhead;
+}
+
+double * MathInterpreter::run(RunContext &context) const
+{
+    ExecutionProfile &profile = context.profile_ ? *context.profile_
+                                                 : profile_;
+
+    if (profile.isEnabled())
+    {
+        double *out = runVm<true>(context);
+
+        mergeProfile(context, profile);
+
+        return out;
+    }
+    else
+    {
+        return runVm<false>(context);
+    }
+}
+
+// WARNING: runVm is called for every evaluation of a compiled function,
+// the switch below is the whole virtual machine; with profile set, the time
+// elapsed since the previous operation is charged to each operation
+template <bool profile>
+double * MathInterpreter::runVm(RunContext &context) const
+{
+    typedef ByteCode::OpCode OpCode;
+    typedef chrono::steady_clock Clock;
+
+    if ((context.vMem_.size() < byteCode_.getNVariable())
+        or (context.fMem_.size() < byteCode_.getNFunction()))
+    {
+        LATAN_ERROR(Range, "run context does not match compiled program '"
+                    + codeName_ + "'");
+    }
+    if (context.vmStack_.size() < byteCode_.getMaxStackDepth())
+    {
+        context.vmStack_.resize(byteCode_.getMaxStackDepth());
+    }
+
+    if (profile)
+    {
+        context.vmProfile_.resize(byteCode_.size());
+    }
+
+    const ByteCode::Op *op   = byteCode_.data();
+    const ByteCode::Op *end  = op + byteCode_.size();
+    const double       *cst  = byteCode_.constantData();
+    double             *var  = context.vMem_.data();
+    DoubleFunction     **fun = context.fMem_.data();
+    double             *base = context.vmStack_.data(), *top = base;
+    InstructionProfile *prof = context.vmProfile_.data();
+    double             tick  = 0.;
+    Clock::time_point  last;
+
+    if (profile)
+    {
+        tick = clockOverhead();
+        last = Clock::now();
+    }
+    for (; op != end; ++op)
+    {
+        switch (op->code)
+        {
+            case OpCode::pushCst:
+                *(top++) = cst[op->arg];
+                break;
+            case OpCode::pushVar:
+                *(top++) = var[op->arg];
+                break;
+            case OpCode::pop:
+                var[op->arg] = *(--top);
+                break;
+            case OpCode::drop:
+                --top;
+                break;
+            case OpCode::store:
+                var[op->arg] = *(top - 1);
+                break;
+            case OpCode::dup:
+                *top = *(top - 1);
+                top++;
+                break;
+            case OpCode::call:
+                if (!fun[op->arg])
+                {
+                    LATAN_ERROR(Program, "call to a null function at address "
+                                + strFrom(op->arg));
+                }
+                top   -= op->nArg;
+                *top   = (*fun[op->arg])(top);
+                top++;
+                break;
+            case OpCode::intrinsic1:
+                *(top - 1) = intrinsic[op->arg].f1(*(top - 1));
+                break;
+            case OpCode::intrinsic2:
+                --top;
+                *(top - 1) = intrinsic[op->arg].f2(*(top - 1), *top);
+                break;
+            case OpCode::neg:
+                *(top - 1) = -*(top - 1);
+                break;
+            case OpCode::add:
+                --top;
+                *(top - 1) += *top;
+                break;
+            case OpCode::sub:
+                --top;
+                *(top - 1) -= *top;
+                break;
+            case OpCode::mul:
+                --top;
+                *(top - 1) *= *top;
+                break;
+            case OpCode::div:
+                --top;
+                *(top - 1) /= *top;
+                break;
+            case OpCode::pow:
+                --top;
+                *(top - 1) = pow(*(top - 1), *top);
+                break;
+        }
+        if (profile)
+        {
+            auto               now = Clock::now();
+            InstructionProfile &p  = prof[op - byteCode_.data()];
+
+            p.count++;
+            p.time += max(0., chrono::duration<double, nano>(now - last)
+                              .count() - tick);
+            last    = now;
+        }
+    }
+    if (top == base)
+    {
+        LATAN_ERROR(Program, "program execution resulted in an empty stack");
+    }
+    
+    return base;
+}
+
+// batched virtual machine: lanes are processed in blocks of VM_LANE_BLOCK,
+// each stack slot and variable is a row of VM_LANE_BLOCK values and every
+// opcode is a loop over the lanes of the block
+#define VM_LANE_BLOCK 64
+#define FOR_LANE(l) for (Index l = 0; l < nBlock; ++l)
+
+void MathInterpreter::execute(double *res, RunContext &context,
+                              const Index nLane,
+                              const vector<unsigned int> &laneAddress,
+                              const double *laneData) const
+{
+    ExecutionProfile &profile = context.profile_ ? *context.profile_
+                                                 : profile_;
+
+    if (profile.isEnabled())
+    {
+        runBatchVm<true>(res, context, nLane, laneAddress, laneData);
+        mergeProfile(context, profile);
+    }
+    else
+    {
+        runBatchVm<false>(res, context, nLane, laneAddress, laneData);
+    }
+}
+
+template <bool profile>
+void MathInterpreter::runBatchVm(double *res, RunContext &context,
+                                 const Index nLane,
+                                 const vector<unsigned int> &laneAddress,
+                                 const double *laneData) const
+{
+    typedef ByteCode::OpCode OpCode;
+    typedef chrono::steady_clock Clock;
+
+    const Index  nVar    = static_cast<Index>(context.vMem_.size());
+    const Index  depth   = byteCode_.getMaxStackDepth();
+    const Index  nOutput = byteCode_.getStackDepth();
+    vector<bool> isUniform(nVar, true), isAssigned(nVar, false);
+
+    if ((context.vMem_.size() < byteCode_.getNVariable())
+        or (context.fMem_.size() < byteCode_.getNFunction()))
+    {
+        LATAN_ERROR(Range, "run context does not match compiled program '"
+                    + codeName_ + "'");
+    }
+    for (auto a: laneAddress)
+    {
+        if (static_cast<Index>(a) >= nVar)
+        {
+            LATAN_ERROR(Range, "variable address " + strFrom(a)
+                        + " out of range");
+        }
+        isUniform[a] = false;
+    }
+    context.vmLaneStack_.resize(depth*VM_LANE_BLOCK);
+    context.vmLaneVar_.resize(nVar*VM_LANE_BLOCK);
+    if (profile)
+    {
+        context.vmProfile_.resize(byteCode_.size());
+    }
+
+    const ByteCode::Op *begin = byteCode_.data();
+    const ByteCode::Op *end   = begin + byteCode_.size();
+    const double       *cst   = byteCode_.constantData();
+    const double       *var   = context.vMem_.data();
+    DoubleFunction     **fun  = context.fMem_.data();
+    double             *lVar  = context.vmLaneVar_.data();
+    double             *base  = context.vmLaneStack_.data();
+    InstructionProfile *prof  = context.vmProfile_.data();
+    double             tick   = profile ? clockOverhead() : 0.;
+    vector<double>     arg;
+
+    // uniform variables are broadcast once, except the ones assigned by the
+    // program which are restored for each block
+    for (const ByteCode::Op *op = begin; op != end; ++op)
+    {
+        if ((op->code == OpCode::pop) or (op->code == OpCode::store))
+        {
+            isAssigned[op->arg] = true;
+        }
+        else if (op->code == OpCode::call)
+        {
+            arg.resize(max(arg.size(), static_cast<size_t>(op->nArg)));
+        }
+    }
+    for (Index v = 0; v < nVar; ++v)
+    {
+        if (isUniform[v])
+        {
+            fill(lVar + v*VM_LANE_BLOCK, lVar + (v + 1)*VM_LANE_BLOCK,
+                 var[v]);
+        }
+    }
+    for (Index l0 = 0; l0 < nLane; l0 += VM_LANE_BLOCK)
+    {
+        const Index nBlock = min(static_cast<Index>(VM_LANE_BLOCK),
+                                 nLane - l0);
+        double      *top   = base;
+
+        for (Index i = 0; i < static_cast<Index>(laneAddress.size()); ++i)
+        {
+            const double *x = laneData + i*nLane + l0;
+            double       *y = lVar + laneAddress[i]*VM_LANE_BLOCK;
+
+            FOR_LANE(l)
+            {
+                y[l] = x[l];
+            }
+        }
+        if (l0 > 0)
+        {
+            for (Index v = 0; v < nVar; ++v)
+            {
+                if (isUniform[v] and isAssigned[v])
+                {
+                    fill(lVar + v*VM_LANE_BLOCK,
+                         lVar + (v + 1)*VM_LANE_BLOCK, var[v]);
+                }
+            }
+        }
+        Clock::time_point last;
+
+        if (profile)
+        {
+            last = Clock::now();
+        }
+        for (const ByteCode::Op *op = begin; op != end; ++op)
+        {
+            double *a = top - VM_LANE_BLOCK, *b = top;
+
+            switch (op->code)
+            {
+                case OpCode::pushCst:
+                    FOR_LANE(l)
+                    {
+                        b[l] = cst[op->arg];
+                    }
+                    top += VM_LANE_BLOCK;
+                    break;
+                case OpCode::pushVar:
+                {
+                    const double *v = lVar + op->arg*VM_LANE_BLOCK;
+
+                    FOR_LANE(l)
+                    {
+                        b[l] = v[l];
+                    }
+                    top += VM_LANE_BLOCK;
+                    break;
+                }
+                case OpCode::pop:
+                case OpCode::store:
+                {
+                    double *v = lVar + op->arg*VM_LANE_BLOCK;
+
+                    FOR_LANE(l)
+                    {
+                        v[l] = a[l];
+                    }
+                    if (op->code == OpCode::pop)
+                    {
+                        top -= VM_LANE_BLOCK;
+                    }
+                    break;
+                }
+                case OpCode::drop:
+                    top -= VM_LANE_BLOCK;
+                    break;
+                case OpCode::dup:
+                    FOR_LANE(l)
+                    {
+                        b[l] = a[l];
+                    }
+                    top += VM_LANE_BLOCK;
+                    break;
+                case OpCode::call:
+                {
+                    const DoubleFunction *f = fun[op->arg];
+                    
+                    if (!f)
+                    {
+                        LATAN_ERROR(Program, "call to a null function at "
+                                    "address " + strFrom(op->arg));
+                    }
+                    top -= op->nArg*VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        for (unsigned int i = 0; i < op->nArg; ++i)
+                        {
+                            arg[i] = top[i*VM_LANE_BLOCK + l];
+                        }
+                        top[l] = (*f)(arg.data());
+                    }
+                    top += VM_LANE_BLOCK;
+                    break;
+                }
+                case OpCode::intrinsic1:
+                {
+                    auto f = intrinsic[op->arg].f1;
+
+                    FOR_LANE(l)
+                    {
+                        a[l] = f(a[l]);
+                    }
+                    break;
+                }
+                case OpCode::intrinsic2:
+                {
+                    auto f = intrinsic[op->arg].f2;
+
+                    a -= VM_LANE_BLOCK;
+                    b -= VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        a[l] = f(a[l], b[l]);
+                    }
+                    top -= VM_LANE_BLOCK;
+                    break;
+                }
+                case OpCode::neg:
+                    FOR_LANE(l)
+                    {
+                        a[l] = -a[l];
+                    }
+                    break;
+                case OpCode::add:
+                    a -= VM_LANE_BLOCK;
+                    b -= VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        a[l] += b[l];
+                    }
+                    top -= VM_LANE_BLOCK;
+                    break;
+                case OpCode::sub:
+                    a -= VM_LANE_BLOCK;
+                    b -= VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        a[l] -= b[l];
+                    }
+                    top -= VM_LANE_BLOCK;
+                    break;
+                case OpCode::mul:
+                    a -= VM_LANE_BLOCK;
+                    b -= VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        a[l] *= b[l];
+                    }
+                    top -= VM_LANE_BLOCK;
+                    break;
+                case OpCode::div:
+                    a -= VM_LANE_BLOCK;
+                    b -= VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        a[l] /= b[l];
+                    }
+                    top -= VM_LANE_BLOCK;
+                    break;
+                case OpCode::pow:
+                    a -= VM_LANE_BLOCK;
+                    b -= VM_LANE_BLOCK;
+                    FOR_LANE(l)
+                    {
+                        a[l] = pow(a[l], b[l]);
+                    }
+                    top -= VM_LANE_BLOCK;
+                    break;
+            }
+            if (profile)
+            {
+                auto               now = Clock::now();
+                InstructionProfile &p  = prof[op - begin];
+
+                p.count += nBlock;
+                p.time  += max(0., chrono::duration<double, nano>(now - last)
+                                   .count() - tick);
+                last     = now;
+            }
+        }
+        if (top == base)
+        {
+            LATAN_ERROR(Program, "program execution resulted in an empty "
+                        "stack");
+        }
+        for (Index o = 0; o < nOutput; ++o)
+        {
+            FOR_LANE(l)
+            {
+                res[o*nLane + l0 + l] = base[o*VM_LANE_BLOCK + l];
+            }
+        }
+    }
+}
+
+// profiling ///////////////////////////////////////////////////////////////////
+bool MathInterpreter::isProfiling(void) const
+{
+    return profile_.isEnabled();
+}
+
+void MathInterpreter::setProfiling(const bool enable)
+{
+    profile_.enable(enable);
+}
+
+vector<InstructionProfile> MathInterpreter::getProfile(void) const
+{
+    return profile_.get();
+}
+
+void MathInterpreter::resetProfile(void)
+{
+    profile_.reset();
+}
+
+void MathInterpreter::mergeProfile(RunContext &context,
+                                   ExecutionProfile &profile) const
+{
+    lock_guard<mutex> lock(profile.mutex_);
+    auto              &prof = context.vmProfile_;
+
+    profile.profile_.resize(program_.size());
+    for (unsigned int o = 0; o < prof.size(); ++o)
+    {
+        auto &p = profile.profile_[opInstruction_[o]];
+
+        p.count += prof[o].count;
+        p.time  += prof[o].time;
+        prof[o]  = InstructionProfile();
+    }
+}
+
+// IO //////////////////////////////////////////////////////////////////////////
+#define PROFILE_WIDTH 24
+
+static string profileString(const InstructionProfile &p, const double total)
+{
+    ostringstream buf;
+
+    buf << "# " << p.count << " x " << p.time << " ns (" << fixed
+        << setprecision(1) << 100.*p.time/total << "%)";
+
+    return buf.str();
+}
+
+// when a profile has been recorded, each instruction is followed by its
+// number of executions and its cumulative time, and the time spent in each
+// called function is summarized at the end
+void MathInterpreter::print(ostream &out, const ExecutionProfile &prof) const
+{
+    auto                            profile = prof.get();
+    double                          total   = 0.;
+    map<string, InstructionProfile> call;
+
+    if (profile.size() == program_.size())
+    {
+        for (auto &p: profile)
+        {
+            total += p.time;
+        }
+    }
+    for (unsigned int i = 0; i < program_.size(); ++i)
+    {
+        const Instruction *ins = program_[i].get();
+
+        if (total > 0.)
+        {
+            ostringstream buf;
+            auto          *c  = dynamic_cast<const Call *>(ins);
+            auto          *in = dynamic_cast<const Intrinsic *>(ins);
+
+            buf << *ins;
+            out << setw(PROFILE_WIDTH) << left << buf.str() << " "
+                << profileString(profile[i], total) << endl;
+            if (c or in)
+            {
+                auto &p = call[c ? c->getName() : in->getName()];
+
+                p.count += profile[i].count;
+                p.time  += profile[i].time;
+            }
+        }
+        else
+        {
+            out << *ins << endl;
+        }
+    }
+    if (total > 0.)
+    {
+        out << "-- profile: " << profile[0].count << " execution(s), "
+            << total/profile[0].count << " ns/execution" << endl;
+        for (auto &c: call)
+        {
+            out << CODE_MOD << "call" << setw(PROFILE_WIDTH - CODE_WIDTH)
+                << left << c.first << " " << profileString(c.second, total)
+                << endl;
+        }
+    }
+}
+
+ostream &Latan::operator<<(ostream &out, const MathInterpreter &program)
+{
+    program.print(out, program.profile_);
+    
     return out;
 }
+
+/******************************************************************************
+ *                      CompiledProgram implementation                        *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+static unsigned long newProgramId(void)
+{
+    static atomic<unsigned long> count{0};
+
+    return ++count;
+}
+
+CompiledProgram::CompiledProgram(const string &code,
+                                 const vector<string> &varName)
+: id_(newProgramId())
+, alive_(new bool(true))
+, code_(code)
+, varName_(varName)
+, interpreter_(code)
+{}
+
+// access //////////////////////////////////////////////////////////////////////
+const string & CompiledProgram::getCode(void) const
+{
+    return code_;
+}
+
+const MathInterpreter & CompiledProgram::getInterpreter(void) const
+{
+    compile();
+
+    return interpreter_;
+}
+
+const vector<unsigned int> & CompiledProgram::getAddress(void) const
+{
+    compile();
+
+    return address_;
+}
+
+// the contexts are owned by the calling thread and indexed by program
+// identifiers (which are never reused), they are released when the thread
+// exits and the contexts of destroyed programs are pruned on the next miss;
+// the profile is set at each call, so that the users of the program sharing a
+// context do not record in the profile of another
+RunContext & CompiledProgram::getContext(ExecutionProfile *profile) const
+{
+    struct ThreadContext
+    {
+        weak_ptr<const bool>   alive;
+        unique_ptr<RunContext> context;
+    };
+    thread_local unordered_map<unsigned long, ThreadContext> threadContext;
+
+    compile();
+
+    auto it = threadContext.find(id_);
+
+    if (it != threadContext.end())
+    {
+        it->second.context->setProfile(profile);
+
+        return *it->second.context;
+    }
+    for (auto i = threadContext.begin(); i != threadContext.end();)
+    {
+        i = i->second.alive.expired() ? threadContext.erase(i) : next(i);
+    }
+
+    auto &c = threadContext[id_];
+
+    c.alive = alive_;
+    c.context.reset(new RunContext(context_));
+    c.context->setProfile(profile);
+
+    return *c.context;
+}
+
+// compile /////////////////////////////////////////////////////////////////////
+void CompiledProgram::compile(void) const
+{
+    if (!isCompiled_.load(memory_order_acquire))
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        if (!isCompiled_.load(memory_order_relaxed))
+        {
+            // a failed compilation leaves the program as constructed
+            try
+            {
+                address_.clear();
+                for (auto &name: varName_)
+                {
+                    address_.push_back(context_.addVariable(name));
+                }
+                interpreter_.compile(context_);
+            }
+            catch (...)
+            {
+                address_.clear();
+                context_.reset();
+                interpreter_.setCode(code_);
+                throw;
+            }
+            isCompiled_.store(true, memory_order_release);
+        }
+    }
+}
+
+// evaluation //////////////////////////////////////////////////////////////////
+double CompiledProgram::evaluate(RunContext &context) const
+{
+    return interpreter_.execute(context);
+}
+
+double CompiledProgram::evaluate(RunContext &context, const Index output) const
+{
+    return interpreter_.execute(context, output);
+}
+
+void CompiledProgram::evaluate(double *res, RunContext &context) const
+{
+    interpreter_.execute(res, context);
+}
+
+void CompiledProgram::evaluate(double *res, RunContext &context,
+                               const Index nLane,
+                               const vector<unsigned int> &laneAddress,
+                               const double *laneData) const
+{
+    interpreter_.execute(res, context, nLane, laneAddress, laneData);
+}
+
+/******************************************************************************
+ *                        ProgramCache implementation                         *
+ ******************************************************************************/
+// default number of programs kept by the process-wide cache
+#define PROGRAM_CACHE_SIZE 256
+
+// constructor /////////////////////////////////////////////////////////////////
+ProgramCache::ProgramCache(const Index capacity)
+: capacity_(capacity)
+{
+    if (capacity_ < 0)
+    {
+        LATAN_ERROR(Size, "negative program cache capacity");
+    }
+}
+
+// process-wide instance ///////////////////////////////////////////////////////
+ProgramCache & ProgramCache::getInstance(void)
+{
+    static ProgramCache cache(PROGRAM_CACHE_SIZE);
+
+    return cache;
+}
+
+// program access //////////////////////////////////////////////////////////////
+// the key separates the code and the variable names with null characters,
+// which cannot appear in a valid program; a missing program is compiled
+// without holding the lock and only inserted once compiled, so that code
+// which fails to compile is never cached (if another thread inserted the
+// same program in the meantime, its instance is returned)
+shared_ptr<const CompiledProgram>
+ProgramCache::get(const string &code, const vector<string> &varName)
+{
+    string key = code;
+
+    for (auto &name: varName)
+    {
+        key.push_back('\0');
+        key += name;
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto              it = index_.find(key);
+
+        if (it != index_.end())
+        {
+            hit_++;
+            entry_.splice(entry_.begin(), entry_, it->second);
+
+            return it->second->second;
+        }
+        miss_++;
+    }
+
+    ProgramPt program(new CompiledProgram(code, varName));
+
+    program->compile();
+
+    lock_guard<mutex> lock(mutex_);
+    auto              it = index_.find(key);
+
+    if (it != index_.end())
+    {
+        return it->second->second;
+    }
+    if (capacity_ > 0)
+    {
+        entry_.emplace_front(key, program);
+        index_[key] = entry_.begin();
+        evict();
+    }
+
+    return program;
+}
+
+// access //////////////////////////////////////////////////////////////////////
+Index ProgramCache::getCapacity(void) const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    return capacity_;
+}
+
+void ProgramCache::setCapacity(const Index capacity)
+{
+    if (capacity < 0)
+    {
+        LATAN_ERROR(Size, "negative program cache capacity");
+    }
+
+    lock_guard<mutex> lock(mutex_);
+
+    capacity_ = capacity;
+    evict();
+}
+
+ProgramCache::Statistics ProgramCache::getStatistics(void) const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    return {hit_, miss_, eviction_, static_cast<Index>(entry_.size()),
+            capacity_};
+}
+
+void ProgramCache::resetStatistics(void)
+{
+    lock_guard<mutex> lock(mutex_);
+
+    hit_      = 0;
+    miss_     = 0;
+    eviction_ = 0;
+}
+
+void ProgramCache::clear(void)
+{
+    lock_guard<mutex> lock(mutex_);
+
+    entry_.clear();
+    index_.clear();
+}
+
+// eviction (mutex must be held) ///////////////////////////////////////////////
+// evicted programs stay alive as long as some function or model uses them
+void ProgramCache::evict(void)
+{
+    while (static_cast<Index>(entry_.size()) > capacity_)
+    {
+        index_.erase(entry_.back().first);
+        entry_.pop_back();
+        eviction_++;
+    }
+}
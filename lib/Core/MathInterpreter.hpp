@@ -28,11 +28,44 @@
 
 BEGIN_LATAN_NAMESPACE
 
+/******************************************************************************
+ *                       Instruction profile                                  *
+ ******************************************************************************/
+// number of executions (one per lane for batched executions) and cumulative
+// execution time in nanoseconds of an instruction
+struct InstructionProfile
+{
+    Index  count{0};
+    double time{0.};
+};
+
+// profile of the executions of a program, while enabled the executions in any
+// thread add their instruction profiles to it
+class ExecutionProfile
+{
+    friend class MathInterpreter;
+public:
+    // constructor
+    ExecutionProfile(void) = default;
+    // destructor
+    ~ExecutionProfile(void) = default;
+    // access
+    bool                            isEnabled(void) const;
+    void                            enable(const bool enable = true);
+    std::vector<InstructionProfile> get(void) const;
+    void                            reset(void);
+private:
+    std::atomic<bool>               enabled_{false};
+    mutable std::mutex              mutex_;
+    std::vector<InstructionProfile> profile_;
+};
+
 /******************************************************************************
  *                       Class for runtime context                            *
  ******************************************************************************/
 class RunContext
 {
+    friend class MathInterpreter;
 public:
     typedef std::map<std::string, unsigned int> AddressTable;
 public:
@@ -50,6 +83,7 @@ public:
     unsigned int         getFunctionAddress(const std::string &name) const;
     const AddressTable & getFunctionTable(void) const;
     unsigned int         getInsIndex(void) const;
+    ExecutionProfile *   getProfile(void) const;
     double               getVariable(const std::string &name) const;
     double               getVariable(const unsigned int address) const;
     unsigned int         getVariableAddress(const std::string &name) const;
@@ -60,6 +94,7 @@ public:
     void                 setFunction(const unsigned int address,
                                      DoubleFunction *f);
     void                 setInsIndex(const unsigned index);
+    void                 setProfile(ExecutionProfile *profile);
     void                 setVariable(const std::string &name,
                                      const double value);
     void                 setVariable(const unsigned int address,
@@ -68,11 +103,71 @@ public:
     // reset
     void                 reset(void);
 private:
-    unsigned int                  insIndex_;
-    std::stack<double>            dStack_;
-    std::vector<double>           vMem_;
-    std::vector<DoubleFunction *> fMem_;
-    AddressTable                  vTable_, fTable_;
+    unsigned int                    insIndex_;
+    std::stack<double>              dStack_;
+    std::vector<double>             vmStack_, vmLaneStack_, vmLaneVar_;
+    std::vector<InstructionProfile> vmProfile_;
+    ExecutionProfile                *profile_{nullptr};
+    std::vector<double>             vMem_;
+    std::vector<DoubleFunction *>   fMem_;
+    AddressTable                    vTable_, fTable_;
+};
+
+/******************************************************************************
+ *                   Byte code for the interpreter virtual machine            *
+ ******************************************************************************/
+// flat instruction array executed by MathInterpreter: each instruction is an
+// opcode and an integer operand (variable/function address, constant pool
+// index or intrinsic index), the value stack depth is known at assembly time
+class ByteCode
+{
+public:
+    enum class OpCode: unsigned char
+    {
+        pushCst = 0,
+        pushVar,
+        pop,
+        drop,
+        store,
+        dup,
+        call,
+        intrinsic1,
+        intrinsic2,
+        neg,
+        add,
+        sub,
+        mul,
+        div,
+        pow
+    };
+    struct Op
+    {
+        OpCode         code;
+        unsigned short nArg;
+        unsigned int   arg;
+    };
+public:
+    // constructor
+    ByteCode(void) = default;
+    // destructor
+    ~ByteCode(void) = default;
+    // access
+    const Op *     data(void) const;
+    const double * constantData(void) const;
+    Index          size(void) const;
+    unsigned int   getMaxStackDepth(void) const;
+    unsigned int   getStackDepth(void) const;
+    unsigned int   getNVariable(void) const;
+    unsigned int   getNFunction(void) const;
+    // assembly
+    void push(const OpCode code, const unsigned int arg = 0,
+              const unsigned int nArg = 0);
+    void pushConstant(const double val);
+    void clear(void);
+private:
+    std::vector<Op>     code_;
+    std::vector<double> constant_;
+    unsigned int        depth_{0}, maxDepth_{0}, nVar_{0}, nFunc_{0};
 };
 
 /******************************************************************************
@@ -86,6 +181,8 @@ public:
     virtual ~Instruction(void) = default;
     // instruction execution
     virtual void operator()(RunContext &context) const = 0;
+    // byte code generation
+    virtual void assemble(ByteCode &code) const = 0;
     friend std::ostream & operator<<(std::ostream &out, const Instruction &ins);
 private:
     virtual void print(std::ostream &out) const = 0;
@@ -111,6 +208,8 @@ public:
     explicit Push(const unsigned int address, const std::string &name);
     // instruction execution
     virtual void operator()(RunContext &context) const;
+    // byte code generation
+    virtual void assemble(ByteCode &code) const;
 private:
     virtual void print(std::ostream& out) const;
 private:
@@ -128,6 +227,8 @@ public:
     explicit Pop(const unsigned int address, const std::string &name);
     // instruction execution
     virtual void operator()(RunContext &context) const;
+    // byte code generation
+    virtual void assemble(ByteCode &code) const;
 private:
     virtual void print(std::ostream& out) const;
 private:
@@ -143,6 +244,8 @@ public:
     explicit Store(const unsigned int address, const std::string &name);
     // instruction execution
     virtual void operator()(RunContext &context) const;
+    // byte code generation
+    virtual void assemble(ByteCode &code) const;
 private:
     virtual void print(std::ostream& out) const;
 private:
@@ -155,26 +258,53 @@ class Call: public Instruction
 {
 public:
     //constructor
-    explicit Call(const unsigned int address, const std::string &name);
+    explicit Call(const unsigned int address, const std::string &name,
+                  const unsigned int nArg = 1);
+    // access
+    const std::string & getName(void) const;
     // instruction execution
     virtual void operator()(RunContext &context) const;
+    // byte code generation
+    virtual void assemble(ByteCode &code) const;
 private:
     virtual void print(std::ostream& out) const;
 private:
-    unsigned int address_;
+    unsigned int address_, nArg_;
     std::string name_;
 };
 
+// Call builtin function directly, bypassing the function table
+class Intrinsic: public Instruction
+{
+public:
+    //constructor
+    explicit Intrinsic(const unsigned int index);
+    // access
+    std::string getName(void) const;
+    // instruction execution
+    virtual void operator()(RunContext &context) const;
+    // byte code generation
+    virtual void assemble(ByteCode &code) const;
+    // intrinsic index of a function, -1 if it is not a builtin
+    static int getIndex(const DoubleFunction *f);
+private:
+    virtual void print(std::ostream& out) const;
+private:
+    unsigned int index_;
+};
+
 // Floating point operations
 #define DECL_OP(name)\
 class name: public Instruction\
 {\
 public:\
     virtual void operator()(RunContext &context) const;\
+    virtual void assemble(ByteCode &code) const;\
 private:\
     virtual void print(std::ostream &out) const;\
 }
 
+DECL_OP(Dup);
 DECL_OP(Neg);
 DECL_OP(Add);
 DECL_OP(Sub);
@@ -199,10 +329,17 @@ public:
     Index              getLevel(void)  const;
     void               setName(const std::string &name);
     void               pushArg(ExprNode *node);
+    void               setArg(const Index i, ExprNode *node);
+    ExprNode *         releaseArg(const Index i);
     // operator
     const ExprNode &operator[](const Index i) const;
+    // copy
+    virtual ExprNode * clone(void) const = 0;
     // compile
     virtual void compile(Program &program, RunContext &context) const = 0;
+protected:
+    // copy arguments into another node
+    void cloneArg(ExprNode &node) const;
 private:
     std::string                             name_;
     std::vector<std::unique_ptr<ExprNode>>  arg_;
@@ -211,25 +348,56 @@ private:
 
 std::ostream &operator<<(std::ostream &out, const ExprNode &n);
 
+// program code corresponding to an AST
+std::string toCode(const ExprNode &ast);
+
+// names of the variables appearing in an AST
+void getVariableNames(std::set<std::string> &names, const ExprNode &ast);
+
+// prefix, obtained by prepending underscores to base, such that no name in
+// names starts with it (used to name compiler-generated variables)
+std::string uniquePrefix(const std::set<std::string> &names,
+                         const std::string &base);
+
 #define DECL_NODE(base, name) \
 class name: public base\
 {\
 public:\
     using base::base;\
+    virtual ExprNode * clone(void) const;\
     virtual void compile(Program &program, RunContext &context) const;\
 }
 
 DECL_NODE(ExprNode, VarNode);
-DECL_NODE(ExprNode, CstNode);
 DECL_NODE(ExprNode, SemicolonNode);
 DECL_NODE(ExprNode, AssignNode);
 DECL_NODE(ExprNode, MathOpNode);
 DECL_NODE(ExprNode, FuncNode);
 
+// integer power computed with a multiplication chain
+DECL_NODE(MathOpNode, IntPowNode);
+
+class CstNode: public ExprNode
+{
+public:
+    // constructors
+    explicit CstNode(const std::string &name);
+    explicit CstNode(const double val);
+    // access
+    double getValue(void) const;
+    // copy
+    virtual ExprNode * clone(void) const;
+    // compile
+    virtual void compile(Program &program, RunContext &context) const;
+private:
+    double val_;
+};
+
 class KeywordNode: public ExprNode
 {
 public:
     using ExprNode::ExprNode;
+    virtual ExprNode * clone(void) const = 0;
     virtual void compile(Program &program, RunContext &context) const = 0;
 };
 
@@ -276,14 +444,52 @@ public:
     ~MathInterpreter(void) = default;
     // access
     const Instruction * operator[](const Index i) const;
-    const ExprNode * getAST(void) const;
+    const ExprNode *    getAST(void) const;
+    const ExprNode *    getOptimizedAST(void) const;
+    const ByteCode &    getByteCode(void) const;
+    Index               getNInstruction(void) const;
+    Index               getNOutput(void) const;
     // initialization
     void setCode(const std::string &code);
+    // optimization (constant folding and algebraic simplifications)
+    bool getOptimization(void) const;
+    void useOptimization(const bool use = true);
+    // parser (called by compile if needed)
+    void parse(void);
     // interpreter
     void compile(RunContext &context);
     // execution
-    void operator()(RunContext &context);
-    // IO
+    void   operator()(RunContext &context);
+    double evaluate(RunContext &context);
+    // batched execution over nLane lanes: the variable at laneAddress[i]
+    // takes the value laneData[i*nLane + l] in lane l and the other variables
+    // are read from the context (struct-of-arrays layout)
+    void   evaluate(double *res, RunContext &context, const Index nLane,
+                    const std::vector<unsigned int> &laneAddress,
+                    const double *laneData);
+    // execution of the compiled program, can be called concurrently as long as
+    // each thread uses its own context; programs ending with
+    // 'return e_0, ..., e_n;' have several outputs: execute(context) returns
+    // the last one, execute(res, context) writes all of them in res and the
+    // batched execution writes the output o of the lane l in res[o*nLane + l]
+    double execute(RunContext &context) const;
+    double execute(RunContext &context, const Index output) const;
+    void   execute(double *res, RunContext &context) const;
+    void   execute(double *res, RunContext &context, const Index nLane,
+                   const std::vector<unsigned int> &laneAddress,
+                   const double *laneData) const;
+    // profiling: while enabled, the executions record the number of
+    // executions and the cumulative time of each instruction, which are
+    // reported by operator<<; the virtual machines are instantiated with and
+    // without instrumentation so disabled profiling has no overhead; the
+    // executions in a context with a profile (see RunContext::setProfile) are
+    // recorded in that profile instead of the interpreter one
+    bool                            isProfiling(void) const;
+    void                            setProfiling(const bool enable = true);
+    std::vector<InstructionProfile> getProfile(void) const;
+    void                            resetProfile(void);
+    // IO, print the program followed by the given profile
+    void print(std::ostream &out, const ExecutionProfile &profile) const;
     friend std::ostream & operator<<(std::ostream &out,
                                      const MathInterpreter &program);
 private:
@@ -291,23 +497,123 @@ private:
     void reset(void);
     // access
     void push(const Instruction *i);
-    // parser
-    void parse(void);
     // interpreter
     void compileNode(const ExprNode &node);
-    // execution
-    void execute(RunContext &context) const;
+    // execution, returns the bottom of the output stack
+    double * run(RunContext &context) const;
+    template <bool profile>
+    double * runVm(RunContext &context) const;
+    template <bool profile>
+    void     runBatchVm(double *res, RunContext &context, const Index nLane,
+                        const std::vector<unsigned int> &laneAddress,
+                        const double *laneData) const;
+    // add the per-operation profile of the context to the program profile
+    void     mergeProfile(RunContext &context, ExecutionProfile &profile) const;
 private:
-    std::unique_ptr<std::istream>    code_{nullptr};
-    std::string                      codeName_{"<no_code>"};
-    std::unique_ptr<MathParserState> state_{nullptr};
-    std::unique_ptr<ExprNode>        root_{nullptr};
-    Program                          program_;
-    unsigned int                     status_{Status::none};
+    std::unique_ptr<std::istream>           code_{nullptr};
+    std::string                             codeName_{"<no_code>"};
+    std::unique_ptr<MathParserState>        state_{nullptr};
+    std::unique_ptr<ExprNode>               root_{nullptr}, optRoot_{nullptr};
+    Program                                 program_;
+    ByteCode                                byteCode_;
+    std::vector<unsigned int>               opInstruction_;
+    bool                                    optimize_{true};
+    unsigned int                            status_{Status::none};
+    mutable ExecutionProfile                profile_;
 };
 
 std::ostream & operator<<(std::ostream &out, const MathInterpreter &program);
 
+/******************************************************************************
+ *                Compiled program with per-thread contexts                   *
+ ******************************************************************************/
+// the program is compiled once on first use, then the interpreter and the
+// context template are read-only and each thread evaluates the program in its
+// own copy of the context
+class CompiledProgram
+{
+    friend class ProgramCache;
+public:
+    // constructor
+    CompiledProgram(const std::string &code,
+                    const std::vector<std::string> &varName);
+    // destructor
+    ~CompiledProgram(void) = default;
+    // access
+    const std::string &               getCode(void) const;
+    const MathInterpreter &           getInterpreter(void) const;
+    const std::vector<unsigned int> & getAddress(void) const;
+    // context of the calling thread, the executions in it are recorded in
+    // profile if it is not null and enabled
+    RunContext &                      getContext(ExecutionProfile *profile
+                                                 = nullptr) const;
+    // evaluation (see MathInterpreter::execute for multiple outputs)
+    double evaluate(RunContext &context) const;
+    double evaluate(RunContext &context, const Index output) const;
+    void   evaluate(double *res, RunContext &context) const;
+    void   evaluate(double *res, RunContext &context, const Index nLane,
+                    const std::vector<unsigned int> &laneAddress,
+                    const double *laneData) const;
+private:
+    // compile
+    void compile(void) const;
+private:
+    const unsigned long               id_;
+    const std::shared_ptr<const bool> alive_;
+    const std::string                 code_;
+    const std::vector<std::string>    varName_;
+    mutable MathInterpreter           interpreter_;
+    mutable RunContext                context_;
+    mutable std::vector<unsigned int> address_;
+    mutable std::atomic<bool>         isCompiled_{false};
+    mutable std::mutex                mutex_;
+};
+
+/******************************************************************************
+ *                Process-wide cache of compiled programs                     *
+ ******************************************************************************/
+// thread-safe LRU cache of compiled programs keyed by code and variable
+// layout, a compiled program is immutable and the cached instance (with its
+// parsed AST and byte code) is shared by all the users of the same code
+class ProgramCache
+{
+public:
+    struct Statistics
+    {
+        Index hit, miss, eviction, size, capacity;
+    };
+public:
+    // constructor
+    explicit ProgramCache(const Index capacity);
+    // destructor
+    ~ProgramCache(void) = default;
+    // process-wide instance
+    static ProgramCache & getInstance(void);
+    // compiled program for the given code and variables, the oldest unused
+    // program is evicted when the cache is full, a zero capacity disables
+    // caching
+    std::shared_ptr<const CompiledProgram>
+               get(const std::string &code,
+                   const std::vector<std::string> &varName);
+    // access
+    Index      getCapacity(void) const;
+    void       setCapacity(const Index capacity);
+    Statistics getStatistics(void) const;
+    void       resetStatistics(void);
+    void       clear(void);
+private:
+    void       evict(void);
+private:
+    typedef std::shared_ptr<const CompiledProgram>      ProgramPt;
+    typedef std::list<std::pair<std::string, ProgramPt>> EntryList;
+    typedef std::unordered_map<std::string, EntryList::iterator> EntryIndex;
+private:
+    Index              capacity_, hit_{0}, miss_{0}, eviction_{0};
+    EntryList          entry_;
+    EntryIndex         index_;
+    mutable std::mutex mutex_;
+};
+
 END_LATAN_NAMESPACE
 
 #endif // Latan_MathInterpreter_hpp_
@@ -280,21 +280,25 @@ PlotPredBand::PlotPredBand(const DoubleFunctionSample &function,
                            const double xMin, const double xMax,
                            const unsigned int nPoint, const double opacity)
 {
-    DMat       dLow(nPoint, 2), dHigh(nPoint, 2);
-    DSample    pred(function.size());
+    DMat       dLow(nPoint, 2), dHigh(nPoint, 2), x(nPoint, 1), err;
+    DMatSample pred;
     double     dx = (xMax - xMin)/static_cast<double>(nPoint - 1);
     string     lowFileName, highFileName;
     
+    // all the points of a sample are computed in one (batched) call and the
+    // samples are computed in parallel (cf. DoubleFunctionSample)
     for (Index i = 0; i < nPoint; ++i)
     {
-        double x = xMin + i*dx, err;
-        
-        pred        = function(x);
-        err         = sqrt(pred.variance());
-        dLow(i, 0)  = x;
-        dLow(i, 1)  = pred[central] - err;
-        dHigh(i, 0) = x;
-        dHigh(i, 1) = pred[central] + err;
+        x(i) = xMin + i*dx;
+    }
+    pred = function.sample(x);
+    err  = pred.variance().cwiseSqrt();
+    for (Index i = 0; i < nPoint; ++i)
+    {
+        dLow(i, 0)  = x(i);
+        dLow(i, 1)  = pred[central](i) - err(i);
+        dHigh(i, 0) = x(i);
+        dHigh(i, 1) = pred[central](i) + err(i);
     }
     makePredBand(dLow, dHigh, opacity);
 }
@@ -19,6 +19,7 @@
 
 #include <LatAnalyze/Functional/CompiledFunction.hpp>
 #include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Core/MathDerivative.hpp>
 #include <LatAnalyze/includes.hpp>
 
 using namespace std;
@@ -27,6 +28,18 @@ using namespace Latan;
 /******************************************************************************
  *                   Compiled double function implementation                  *
  ******************************************************************************/
+// check that some code was set before using the program
+static const CompiledProgram &
+checkProgram(const shared_ptr<const CompiledProgram> &program)
+{
+    if (!program)
+    {
+        LATAN_ERROR(Program, "compiled function has no code");
+    }
+
+    return *program;
+}
+
 // constructors ////////////////////////////////////////////////////////////////
 CompiledDoubleFunction::CompiledDoubleFunction(const Index nArg)
 : nArg_(nArg)
@@ -47,58 +60,75 @@ string CompiledDoubleFunction::getCode(void)
 
 void CompiledDoubleFunction::setCode(const string &code)
 {
-    code_ = code;
-    interpreter_.reset(new MathInterpreter(code));
-    context_.reset(new RunContext);
-    varAddress_.reset(new std::vector<unsigned int>);
-    isCompiled_.reset(new bool(false));
-}
+    vector<string> varName;
 
-// compile /////////////////////////////////////////////////////////////////////
-void CompiledDoubleFunction::compile(void) const
-{
-    if (!*isCompiled_)
+    for (Index i = 0; i < nArg_; ++i)
     {
-        varAddress_->clear();
-        for (Index i = 0; i < nArg_; ++i)
-        {
-            varAddress_->push_back(context_->addVariable("x_" + strFrom(i)));
-        }
-        interpreter_->compile(*(context_));
-        *isCompiled_ = true;
+        varName.push_back("x_" + strFrom(i));
     }
+    auto program = ProgramCache::getInstance().get(code, varName);
+
+    if (program->getInterpreter().getNOutput() > 1)
+    {
+        LATAN_ERROR(Compilation, "compiled functions have a single output");
+    }
+    code_    = code;
+    program_ = program;
+    profile_->reset();
 }
 
 // function call ///////////////////////////////////////////////////////////////
 double CompiledDoubleFunction::operator()(const double *arg) const
 {
-    double result;
-    
-    compile();
+    RunContext &context = checkProgram(program_).getContext(profile_.get());
+    auto       &address = program_->getAddress();
+
     for (unsigned int i = 0; i < nArg_; ++i)
     {
-        context_->setVariable((*varAddress_)[i], arg[i]);
-    }
-    (*interpreter_)(*context_);
-    if (!context_->stack().empty())
-    {
-        result = context_->stack().top();
-        context_->stack().pop();
+        context.setVariable(address[i], arg[i]);
     }
-    else
+    
+    return program_->evaluate(context);
+}
+
+void CompiledDoubleFunction::operator()(double *res, const double *arg,
+                                        const Index nPoint) const
+{
+    RunContext &context = checkProgram(program_).getContext(profile_.get());
+
+    program_->evaluate(res, context, nPoint, program_->getAddress(), arg);
+}
+
+// symbolic derivative /////////////////////////////////////////////////////////
+CompiledDoubleFunction CompiledDoubleFunction::argDerivative(const Index i)
+const
+{
+    if ((i < 0) or (i >= nArg_))
     {
-        result = 0.0;
-        LATAN_ERROR(Program, "program execution resulted in an empty stack");
+        LATAN_ERROR(Range, "argument index out of range");
     }
-    
-    return result;
+
+    return CompiledDoubleFunction(derivativeCode(code_, "x_" + strFrom(i)),
+                                  nArg_);
+}
+
+// profiling ///////////////////////////////////////////////////////////////////
+void CompiledDoubleFunction::setProfiling(const bool enable) const
+{
+    checkProgram(program_);
+    profile_->enable(enable);
+}
+
+void CompiledDoubleFunction::resetProfile(void) const
+{
+    checkProgram(program_);
+    profile_->reset();
 }
 
 // IO //////////////////////////////////////////////////////////////////////////
 ostream & Latan::operator<<(ostream &out, CompiledDoubleFunction &f)
 {
-    f.compile();
-    out << *(f.interpreter_);
+    checkProgram(f.program_).getInterpreter().print(out, *f.profile_);
     
     return out;
 }
@@ -114,10 +144,14 @@ DoubleFunction CompiledDoubleFunction::makeFunction(const bool makeHardCopy)
         CompiledDoubleFunction copy(*this);
 
         res.setFunction([copy](const double *p){return copy(p);}, nArg_);
+        res.setBatchFunction([copy](double *r, const double *p,
+                                    const Index n){copy(r, p, n);});
     }
     else
     {
         res.setFunction([this](const double *p){return (*this)(p);}, nArg_);
+        res.setBatchFunction([this](double *r, const double *p,
+                                    const Index n){(*this)(r, p, n);});
     }
     
     return res;
@@ -29,6 +29,8 @@ BEGIN_LATAN_NAMESPACE
 /******************************************************************************
  *                      compiled double function class                        *
  ******************************************************************************/
+// the compiled program is shared with the copies and with the other objects
+// compiled from the same code (see ProgramCache), evaluation is thread-safe
 class CompiledDoubleFunction: public DoubleFunctionFactory
 {
 public:
@@ -42,22 +44,24 @@ public:
     void        setCode(const std::string &code);
     // function call
     double operator()(const double *arg) const;
+    // batched call, arg[i*nPoint + k] is the argument i of the point k
+    void   operator()(double *res, const double *arg, const Index nPoint) const;
+    // symbolic derivative with respect to the argument i
+    CompiledDoubleFunction argDerivative(const Index i) const;
+    // profiling of the evaluations of this function and its copies (see
+    // MathInterpreter), reported by operator<<
+    void setProfiling(const bool enable = true) const;
+    void resetProfile(void) const;
     // IO
     friend std::ostream & operator<<(std::ostream &out,
                                      CompiledDoubleFunction &f);
     // factory
     virtual DoubleFunction makeFunction(const bool makeHardCopy = true) const;
 private:
-
-    // compile
-    void compile(void) const;
-private:
-    Index                                      nArg_;
-    std::string                                code_;
-    std::shared_ptr<MathInterpreter>           interpreter_;
-    std::shared_ptr<RunContext>                context_;
-    std::shared_ptr<std::vector<unsigned int>> varAddress_;
-    std::shared_ptr<bool>                      isCompiled_;
+    Index                                  nArg_;
+    std::string                            code_;
+    std::shared_ptr<const CompiledProgram> program_;
+    std::shared_ptr<ExecutionProfile>      profile_{new ExecutionProfile};
 };
 
 std::ostream & operator<<(std::ostream &out, CompiledDoubleFunction &f);
@@ -19,6 +19,8 @@
 
 #include <LatAnalyze/Functional/CompiledModel.hpp>
 #include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/Core/MathDerivative.hpp>
+#include <LatAnalyze/Core/MathFusion.hpp>
 #include <LatAnalyze/includes.hpp>
 
 using namespace std;
@@ -27,6 +29,91 @@ using namespace Latan;
 /******************************************************************************
  *                 CompiledDoubleModel implementation                         *
  ******************************************************************************/
+// set the arguments and parameters in the context of the calling thread
+static RunContext & setModelVariables(const CompiledProgram &program,
+                                      const Index nArg, const Index nPar,
+                                      const double *arg, const double *par,
+                                      ExecutionProfile *profile = nullptr)
+{
+    RunContext &context = program.getContext(profile);
+    auto       &address = program.getAddress();
+
+    for (Index i = 0; i < nArg; ++i)
+    {
+        context.setVariable(address[i], arg[i]);
+    }
+    for (Index j = 0; j < nPar; ++j)
+    {
+        context.setVariable(address[nArg + j], par[j]);
+    }
+
+    return context;
+}
+
+// check that some code was set before using the program
+static const CompiledProgram &
+checkProgram(const shared_ptr<const CompiledProgram> &program)
+{
+    if (!program)
+    {
+        LATAN_ERROR(Program, "compiled model has no code");
+    }
+
+    return *program;
+}
+
+// parameter binding: the parts of the program which only depend on the
+// parameters are computed once by a prelude program, then a body program is
+// evaluated for each point with the prelude outputs as extra variables
+static DoubleModel::parBindFunc makeParBind(const CompiledProgram &program,
+                                            const Index nArg,
+                                            const Index nPar)
+{
+    unique_ptr<ExprNode> prelude, body;
+    set<string>          pointVar;
+    vector<string>       parName, bodyVar, output;
+
+    for (Index i = 0; i < nArg; ++i)
+    {
+        pointVar.insert("x_" + strFrom(i));
+        bodyVar.push_back("x_" + strFrom(i));
+    }
+    for (Index j = 0; j < nPar; ++j)
+    {
+        parName.push_back("p_" + strFrom(j));
+        bodyVar.push_back("p_" + strFrom(j));
+    }
+    if (!hoistInvariant(prelude, body, output,
+                        *program.getInterpreter().getAST(), pointVar))
+    {
+        return nullptr;
+    }
+    bodyVar.insert(bodyVar.end(), output.begin(), output.end());
+
+    auto        &cache = ProgramCache::getInstance();
+    auto        pre    = cache.get(toCode(*prelude), parName);
+    auto        post   = cache.get(toCode(*body), bodyVar);
+    const Index nOut   = static_cast<Index>(output.size());
+
+    return [pre, post, nArg, nPar, nOut](const double *par)
+    {
+        RunContext     &context = setModelVariables(*pre, 0, nPar, nullptr,
+                                                    par);
+        vector<double> val(nPar + nOut);
+
+        copy(par, par + nPar, val.begin());
+        pre->evaluate(val.data() + nPar, context);
+
+        return [post, nArg, val](const double *x)
+        {
+            RunContext &context = setModelVariables(*post, nArg, val.size(),
+                                                    x, val.data());
+
+            return post->evaluate(context);
+        };
+    };
+}
+
 // constructor /////////////////////////////////////////////////////////////////
 CompiledDoubleModel::CompiledDoubleModel(const Index nArg, const Index nPar)
 : nArg_(nArg)
@@ -48,69 +135,152 @@ string CompiledDoubleModel::getCode(void)
 
 void CompiledDoubleModel::setCode(const std::string &code)
 {
-    code_ = code;
-    interpreter_.reset(new MathInterpreter(code_));
-    context_.reset(new RunContext);
-    varAddress_.reset(new std::vector<unsigned int>);
-    parAddress_.reset(new std::vector<unsigned int>);
-    isCompiled_.reset(new bool(false));
-}
+    vector<string> varName;
 
-// compile /////////////////////////////////////////////////////////////////////
-void CompiledDoubleModel::compile(void) const
-{
-    if (!*isCompiled_)
+    for (Index i = 0; i < nArg_; ++i)
     {
-        varAddress_->clear();
-        parAddress_->clear();
-        for (Index i = 0; i < nArg_; ++i)
-        {
-            varAddress_->push_back(context_->addVariable("x_" + strFrom(i)));
-        }
-        for (Index j = 0; j < nPar_; ++j)
-        {
-            parAddress_->push_back(context_->addVariable("p_" + strFrom(j)));
-        }
-        interpreter_->compile(*(context_));
-        *isCompiled_ = true;
+        varName.push_back("x_" + strFrom(i));
+    }
+    for (Index j = 0; j < nPar_; ++j)
+    {
+        varName.push_back("p_" + strFrom(j));
+    }
+    auto program = ProgramCache::getInstance().get(code, varName);
+
+    if (program->getInterpreter().getNOutput() > 1)
+    {
+        LATAN_ERROR(Compilation, "compiled models have a single output, use "
+                    "FusedDoubleModel for several outputs");
     }
+    code_    = code;
+    program_ = program;
+    grad_.reset(new GradientProgram);
+    profile_->reset();
 }
 
 // function call ///////////////////////////////////////////////////////////////
 double CompiledDoubleModel::operator()(const double *arg,
                                        const double *par) const
 {
-    double result;
-    
-    compile();
-    for (unsigned int i = 0; i < nArg_; ++i)
+    RunContext &context = setModelVariables(checkProgram(program_), nArg_,
+                                            nPar_, arg, par, profile_.get());
+
+    return program_->evaluate(context);
+}
+
+void CompiledDoubleModel::operator()(double *res, const double *arg,
+                                     const double *par,
+                                     const Index nPoint) const
+{
+    RunContext                 &context = checkProgram(program_)
+                                          .getContext(profile_.get());
+    auto                       &address = program_->getAddress();
+    const vector<unsigned int> varAddress(address.begin(),
+                                          address.begin() + nArg_);
+
+    for (unsigned int j = 0; j < nPar_; ++j)
     {
-        context_->setVariable((*varAddress_)[i], arg[i]);
+        context.setVariable(address[nArg_ + j], par[j]);
     }
-    for (unsigned int j = 0; j < nPar_; ++j)
+    program_->evaluate(res, context, nPoint, varAddress, arg);
+}
+
+// symbolic derivatives ////////////////////////////////////////////////////////
+CompiledDoubleModel CompiledDoubleModel::argDerivative(const Index i) const
+{
+    if ((i < 0) or (i >= nArg_))
     {
-        context_->setVariable((*parAddress_)[j], par[j]);
+        LATAN_ERROR(Range, "argument index out of range");
     }
-    (*interpreter_)(*context_);
-    if (!context_->stack().empty())
+
+    return CompiledDoubleModel(derivativeCode(code_, "x_" + strFrom(i)),
+                               nArg_, nPar_);
+}
+
+CompiledDoubleModel CompiledDoubleModel::parDerivative(const Index j) const
+{
+    if ((j < 0) or (j >= nPar_))
     {
-        result = context_->stack().top();
-        context_->stack().pop();
+        LATAN_ERROR(Range, "parameter index out of range");
+    }
+
+    return CompiledDoubleModel(derivativeCode(code_, "p_" + strFrom(j)),
+                               nArg_, nPar_);
+}
+
+// parameter gradient //////////////////////////////////////////////////////////
+void CompiledDoubleModel::parGradient(double *grad, const double *arg,
+                                      const double *par) const
+{
+    checkProgram(program_);
+    call_once(grad_->flag, [this](void)
+    {
+        vector<string> dCode, varName;
+
+        for (Index i = 0; i < nArg_; ++i)
+        {
+            varName.push_back("x_" + strFrom(i));
+        }
+        for (Index j = 0; j < nPar_; ++j)
+        {
+            varName.push_back("p_" + strFrom(j));
+        }
+        try
+        {
+            for (Index j = 0; j < nPar_; ++j)
+            {
+                dCode.push_back(derivativeCode(code_, "p_" + strFrom(j)));
+            }
+            grad_->program = ProgramCache::getInstance().get(fuseCode(dCode),
+                                                             varName);
+        }
+        catch (const Exceptions::Implementation &)
+        {
+            grad_->program = nullptr;
+        }
+    });
+    if (grad_->program)
+    {
+        grad_->program->evaluate(grad, setModelVariables(*grad_->program,
+                                                         nArg_, nPar_, arg,
+                                                         par));
     }
     else
     {
-        result = 0.0;
-        LATAN_ERROR(Program, "program execution resulted in an empty stack");
+        vector<double> p(par, par + nPar_);
+
+        for (Index j = 0; j < nPar_; ++j)
+        {
+            const double h = cbrt(DBL_EPSILON)*max(fabs(par[j]), 1.);
+            double       fp, fm;
+
+            p[j]    = par[j] + h;
+            fp      = (*this)(arg, p.data());
+            p[j]    = par[j] - h;
+            fm      = (*this)(arg, p.data());
+            p[j]    = par[j];
+            grad[j] = (fp - fm)/(2.*h);
+        }
     }
-    
-    return result;
+}
+
+// profiling ///////////////////////////////////////////////////////////////////
+void CompiledDoubleModel::setProfiling(const bool enable) const
+{
+    checkProgram(program_);
+    profile_->enable(enable);
+}
+
+void CompiledDoubleModel::resetProfile(void) const
+{
+    checkProgram(program_);
+    profile_->reset();
 }
 
 // IO //////////////////////////////////////////////////////////////////////////
 ostream & Latan::operator<<(std::ostream &out, CompiledDoubleModel &m)
 {
-    m.compile();
-    out << *(m.interpreter_);
+    checkProgram(m.program_).getInterpreter().print(out, *m.profile_);
     
     return out;
 }
@@ -126,11 +296,27 @@ DoubleModel CompiledDoubleModel::makeModel(const bool makeHardCopy) const
 
         res.setFunction([copy](const double *x, const double *p)
                         {return copy(x, p);}, nArg_, nPar_);
+        res.setBatchFunction([copy](double *r, const double *x,
+                                    const double *p, const Index n)
+                             {copy(r, x, p, n);});
+        res.setParGradientFunction([copy](double *g, const double *x,
+                                          const double *p)
+                                   {copy.parGradient(g, x, p);});
     }
     else
     {
         res.setFunction([this](const double *x, const double *p)
                         {return (*this)(x, p);}, nArg_, nPar_);
+        res.setBatchFunction([this](double *r, const double *x,
+                                    const double *p, const Index n)
+                             {(*this)(r, x, p, n);});
+        res.setParGradientFunction([this](double *g, const double *x,
+                                          const double *p)
+                                   {parGradient(g, x, p);});
+    }
+    if (program_)
+    {
+        res.setParBindFunction(makeParBind(*program_, nArg_, nPar_));
     }
 
     return res;
@@ -143,3 +329,155 @@ DoubleModel Latan::compile(const std::string &code, const Index nArg,
 
     return compiledModel.makeModel();
 }
+
+/******************************************************************************
+ *                   FusedDoubleModel implementation                          *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+FusedDoubleModel::FusedDoubleModel(const vector<string> &code,
+                                   const Index nArg, const Index nPar)
+: nArg_(nArg)
+, nPar_(nPar)
+{
+    vector<string> varName;
+
+    for (Index i = 0; i < nArg_; ++i)
+    {
+        varName.push_back("x_" + strFrom(i));
+    }
+    for (Index j = 0; j < nPar_; ++j)
+    {
+        varName.push_back("p_" + strFrom(j));
+    }
+    code_    = fuseCode(code);
+    program_ = ProgramCache::getInstance().get(code_, varName);
+    nOutput_ = program_->getInterpreter().getNOutput();
+
+    // the shared multi-output function only holds the program, not the model
+    auto program = program_;
+
+    multi_.reset(new DoubleModel::multiFunc(
+        [program, nArg, nPar](double *res, const double *x, const double *p)
+        {
+            program->evaluate(res, setModelVariables(*program, nArg, nPar, x,
+                                                     p));
+        }));
+}
+
+// access //////////////////////////////////////////////////////////////////////
+Index FusedDoubleModel::getNArg(void) const
+{
+    return nArg_;
+}
+
+Index FusedDoubleModel::getNPar(void) const
+{
+    return nPar_;
+}
+
+Index FusedDoubleModel::getNOutput(void) const
+{
+    return nOutput_;
+}
+
+string FusedDoubleModel::getCode(void) const
+{
+    return code_;
+}
+
+// function call ///////////////////////////////////////////////////////////////
+void FusedDoubleModel::operator()(double *res, const double *arg,
+                                  const double *par) const
+{
+    (*multi_)(res, arg, par);
+}
+
+double FusedDoubleModel::operator()(const Index o, const double *arg,
+                                    const double *par) const
+{
+    RunContext &context = setModelVariables(*program_, nArg_, nPar_, arg,
+                                            par);
+
+    return program_->evaluate(context, o);
+}
+
+void FusedDoubleModel::operator()(double *res, const double *arg,
+                                  const double *par, const Index nPoint) const
+{
+    RunContext                 &context = program_->getContext();
+    auto                       &address = program_->getAddress();
+    const vector<unsigned int> varAddress(address.begin(),
+                                          address.begin() + nArg_);
+
+    for (Index j = 0; j < nPar_; ++j)
+    {
+        context.setVariable(address[nArg_ + j], par[j]);
+    }
+    program_->evaluate(res, context, nPoint, varAddress, arg);
+}
+
+// IO //////////////////////////////////////////////////////////////////////////
+ostream & Latan::operator<<(std::ostream &out, const FusedDoubleModel &m)
+{
+    out << m.program_->getInterpreter();
+
+    return out;
+}
+
+// DoubleModel factory /////////////////////////////////////////////////////////
+DoubleModel FusedDoubleModel::makeModel(const Index o,
+                                        const bool makeHardCopy) const
+{
+    DoubleModel res;
+    const Index nOutput = nOutput_;
+
+    if ((o < 0) or (o >= nOutput_))
+    {
+        LATAN_ERROR(Range, "model output index out of range");
+    }
+    if (makeHardCopy)
+    {
+        FusedDoubleModel copy(*this);
+
+        res.setFunction([copy, o](const double *x, const double *p)
+                        {return copy(o, x, p);}, nArg_, nPar_);
+        res.setBatchFunction([copy, o, nOutput](double *r, const double *x,
+                                                const double *p,
+                                                const Index n)
+        {
+            vector<double> buf(nOutput*n);
+
+            copy(buf.data(), x, p, n);
+            std::copy(buf.begin() + o*n, buf.begin() + (o + 1)*n, r);
+        });
+    }
+    else
+    {
+        res.setFunction([this, o](const double *x, const double *p)
+                        {return (*this)(o, x, p);}, nArg_, nPar_);
+        res.setBatchFunction([this, o, nOutput](double *r, const double *x,
+                                                const double *p,
+                                                const Index n)
+        {
+            vector<double> buf(nOutput*n);
+
+            (*this)(buf.data(), x, p, n);
+            std::copy(buf.begin() + o*n, buf.begin() + (o + 1)*n, r);
+        });
+    }
+    res.setMultiFunction(multi_, nOutput_, o);
+
+    return res;
+}
+
+vector<DoubleModel> FusedDoubleModel::makeModels(const bool makeHardCopy) const
+{
+    vector<DoubleModel> res;
+
+    for (Index o = 0; o < nOutput_; ++o)
+    {
+        res.push_back(makeModel(o, makeHardCopy));
+    }
+
+    return res;
+}
@@ -29,8 +29,16 @@ BEGIN_LATAN_NAMESPACE
 /******************************************************************************
  *                     compiled double model class                            *
  ******************************************************************************/
+// the compiled program is shared with the copies and with the other objects
+// compiled from the same code (see ProgramCache), evaluation is thread-safe
 class CompiledDoubleModel: public DoubleModelFactory
 {
+private:
+    struct GradientProgram
+    {
+        std::once_flag                         flag;
+        std::shared_ptr<const CompiledProgram> program{nullptr};
+    };
 public:
     // constructor
     CompiledDoubleModel(const Index nArg, const Index nPar);
@@ -43,25 +51,80 @@ public:
     void        setCode(const std::string &code);
     // function call
     double operator()(const double *arg, const double *par) const;
+    // batched call, arg[i*nPoint + k] is the argument i of the point k
+    void   operator()(double *res, const double *arg, const double *par,
+                      const Index nPoint) const;
+    // symbolic derivatives with respect to the argument i or the parameter j
+    CompiledDoubleModel argDerivative(const Index i) const;
+    CompiledDoubleModel parDerivative(const Index j) const;
+    // gradient with respect to the parameters, computed by a single program
+    // fusing the symbolic derivatives, compiled at the first call (finite
+    // differences are used if the model has no symbolic derivative)
+    void parGradient(double *grad, const double *arg, const double *par) const;
+    // profiling of the evaluations of this model and its copies (see
+    // MathInterpreter), reported by operator<<
+    void setProfiling(const bool enable = true) const;
+    void resetProfile(void) const;
     // IO
     friend std::ostream & operator<<(std::ostream &out,
                                      CompiledDoubleModel &f);
-    // factory
+    // factory, the parameter-only subexpressions of the model are computed
+    // once by DoubleModel::bindPar and the model has a parameter gradient
     DoubleModel makeModel(const bool makeHardCopy = true) const;
 private:
-    // compile
-    void compile(void) const;
-private:
-    Index                                      nArg_, nPar_;
-    std::string                                code_;
-    std::shared_ptr<MathInterpreter>           interpreter_;
-    std::shared_ptr<RunContext>                context_;
-    std::shared_ptr<std::vector<unsigned int>> varAddress_, parAddress_;
-    std::shared_ptr<bool>                      isCompiled_;
+    Index                                  nArg_, nPar_;
+    std::string                            code_;
+    std::shared_ptr<const CompiledProgram> program_;
+    std::shared_ptr<GradientProgram>       grad_;
+    std::shared_ptr<ExecutionProfile>      profile_{new ExecutionProfile};
 };
 
 std::ostream & operator<<(std::ostream &out, CompiledDoubleModel &f);
 
+/******************************************************************************
+ *                 fused multi-output compiled model class                    *
+ ******************************************************************************/
+// several programs with the same arguments and parameters compiled into one
+// program returning all their values, the subexpressions common to several
+// programs being computed once; the models made for each output share the
+// fused program and are evaluated together by the fits
+class FusedDoubleModel
+{
+public:
+    // constructor
+    FusedDoubleModel(const std::vector<std::string> &code, const Index nArg,
+                     const Index nPar);
+    // destructor
+    virtual ~FusedDoubleModel(void) = default;
+    // access
+    Index       getNArg(void) const;
+    Index       getNPar(void) const;
+    Index       getNOutput(void) const;
+    std::string getCode(void) const;
+    // function call, res[o] is the output o
+    void   operator()(double *res, const double *arg, const double *par) const;
+    double operator()(const Index o, const double *arg,
+                      const double *par) const;
+    // batched call, arg[i*nPoint + k] is the argument i of the point k and
+    // res[o*nPoint + k] the output o at the point k
+    void   operator()(double *res, const double *arg, const double *par,
+                      const Index nPoint) const;
+    // IO
+    friend std::ostream & operator<<(std::ostream &out,
+                                     const FusedDoubleModel &f);
+    // factory
+    DoubleModel              makeModel(const Index o,
+                                       const bool makeHardCopy = true) const;
+    std::vector<DoubleModel> makeModels(const bool makeHardCopy = true) const;
+private:
+    Index                                   nArg_, nPar_, nOutput_;
+    std::string                             code_;
+    std::shared_ptr<const CompiledProgram>  program_;
+    std::shared_ptr<DoubleModel::multiFunc> multi_;
+};
+
+std::ostream & operator<<(std::ostream &out, const FusedDoubleModel &f);
+
 // DoubleModel factory
 DoubleModel compile(const std::string &code, const Index nArg,
                     const Index nPar);
@@ -18,6 +18,7 @@
  */
 
 #include <LatAnalyze/Functional/Function.hpp>
+#include <LatAnalyze/Functional/FunctionGraph.hpp>
 #include <LatAnalyze/includes.hpp>
 
 using namespace std;
@@ -44,6 +45,47 @@ void DoubleFunction::setFunction(const vecFunc &f, const Index nArg)
 {
     buffer_->resize(nArg);
     f_ = f;
+    batch_.reset();
+    grad_.reset();
+    graph_.reset();
+}
+
+// the batch function must compute the same values as the function set with
+// setFunction, the latter resets it
+void DoubleFunction::setBatchFunction(const batchFunc &f)
+{
+    if (f)
+    {
+        batch_.reset(new batchFunc(f));
+    }
+    else
+    {
+        batch_.reset();
+    }
+}
+
+bool DoubleFunction::hasBatchFunction(void) const
+{
+    return (batch_ != nullptr);
+}
+
+// f(grad, arg) must write in grad the gradient of the function set with
+// setFunction, the latter resets it
+void DoubleFunction::setGradientFunction(const gradFunc &f)
+{
+    if (f)
+    {
+        grad_.reset(new gradFunc(f));
+    }
+    else
+    {
+        grad_.reset();
+    }
+}
+
+bool DoubleFunction::hasGradientFunction(void) const
+{
+    return (grad_ != nullptr);
 }
 
 VarName & DoubleFunction::varName(void)
@@ -67,6 +109,32 @@ void DoubleFunction::checkSize(const Index nPar) const
     }
 }
 
+// composition graph ///////////////////////////////////////////////////////////
+// a function which is not a composition is a graph with a single leaf
+shared_ptr<const FunctionGraph> DoubleFunction::getGraph(void) const
+{
+    if (graph_)
+    {
+        return graph_;
+    }
+    else
+    {
+        return make_shared<const FunctionGraph>(f_, batch_, getNArg());
+    }
+}
+
+void DoubleFunction::setGraph(const shared_ptr<const FunctionGraph> &graph)
+{
+    setFunction([graph](const double *arg){return (*graph)(arg);},
+                graph->getNArg());
+    setBatchFunction([graph](double *res, const double *arg,
+                             const Index nPoint)
+    {
+        (*graph)(res, arg, nPoint);
+    });
+    graph_ = graph;
+}
+
 // function call ///////////////////////////////////////////////////////////////
 double DoubleFunction::operator()(const double *arg) const
 {
@@ -125,56 +193,65 @@ std::map<double, double> DoubleFunction::operator()(const std::map<double, doubl
     return res;
 }
 
-// bind ////////////////////////////////////////////////////////////////////////
-DoubleFunction DoubleFunction::bind(const Index argIndex,
-                                    const double val) const
+void DoubleFunction::operator()(double *res, const double *arg,
+                                const Index nPoint) const
 {
-    Index            nArg = getNArg();
-    shared_ptr<DVec> buf(new DVec(nArg));
-    DoubleFunction   copy(*this), bindFunc;
-
-    auto func = [copy, buf, argIndex, val](const double *arg)
+    if (batch_)
+    {
+        (*batch_)(res, arg, nPoint);
+    }
+    else
     {
-        FOR_VEC(*buf, i)
+        DVec x(getNArg());
+
+        for (Index k = 0; k < nPoint; ++k)
         {
-            if (i < argIndex)
-            {
-                (*buf)(i) = arg[i];
-            }
-            else if (i == argIndex)
+            FOR_VEC(x, i)
             {
-                (*buf)(i) = val;
-            }
-            else
-            {
-                (*buf)(i) = arg[i - 1];
+                x(i) = arg[i*nPoint + k];
             }
+            res[k] = (*this)(x.data());
         }
+    }
+}
+
+// gradient ////////////////////////////////////////////////////////////////////
+void DoubleFunction::gradient(double *grad, const double *arg) const
+{
+    if (!grad_)
+    {
+        LATAN_ERROR(Definition, "function has no gradient");
+    }
+    (*grad_)(grad, arg);
+}
 
-        return copy(*buf);
-    };
+DVec DoubleFunction::gradient(const DVec &arg) const
+{
+    DVec grad(getNArg());
 
-    bindFunc.setFunction(func, nArg - 1);
+    checkSize(arg.size());
+    gradient(grad.data(), arg.data());
 
-    return bindFunc;
+    return grad;
 }
 
+// bind ////////////////////////////////////////////////////////////////////////
 DoubleFunction DoubleFunction::bind(const Index argIndex,
-                                    const DVec &x) const
+                                    const double val) const
 {
-    Index            nArg = getNArg();
-    shared_ptr<DVec> buf(new DVec(nArg));
-    DoubleFunction   copy(*this), bindFunc;
+    DoubleFunction bindFunc;
 
-    auto func = [copy, buf, argIndex, x](const double *arg)
-    {
-        *buf = x;
-        (*buf)(argIndex) = arg[0];
+    bindFunc.setGraph(FunctionGraph::bind(*getGraph(), argIndex, val));
 
-        return copy(*buf);
-    };
+    return bindFunc;
+}
+
+DoubleFunction DoubleFunction::bind(const Index argIndex,
+                                    const DVec &x) const
+{
+    DoubleFunction bindFunc;
 
-    bindFunc.setFunction(func, 1);
+    bindFunc.setGraph(FunctionGraph::bind(*getGraph(), argIndex, x));
 
     return bindFunc;
 }
@@ -191,30 +268,38 @@ DVec DoubleFunction::sample(const DMat &x) const
     
     DVec res(x.rows());
 
-    for (Index i = 0; i < res.size(); ++i)
-    {
-        res(i) = (*this)(x.row(i));
-    }
+    // DMat is column-major, each column is an argument over all points
+    (*this)(res.data(), x.data(), x.rows());
 
     return res;
 }
 
 // arithmetic operators ////////////////////////////////////////////////////////
+// compositions are flattened in a single graph, the composed functions are
+// not nested in each other
 DoubleFunction DoubleFunction::operator-(void) const
 {
-    DoubleFunction copy(*this), resFunc;
-    
-    return DoubleFunction([copy](const double *arg){return -copy(arg);},
-                          getNArg());
+    DoubleFunction resFunc;
+
+    resFunc.setGraph(FunctionGraph::unary(FunctionGraph::Op::neg, *getGraph()));
+
+    return resFunc;
 }
 
-#define MAKE_SELF_FUNC_OP(op)\
+#define MAKE_SELF_FUNC_OP(op, gop)\
 DoubleFunction & DoubleFunction::operator op##=(const DoubleFunction &f)\
 {\
-    DoubleFunction copy(*this);\
     checkSize(f.getNArg());\
-    auto res = [f, copy](const double *arg){return copy(arg) op f(arg);};\
-    setFunction(res, getNArg());\
+    if (&f == this)\
+    {\
+        auto g = getGraph();\
+        setGraph(FunctionGraph::binary(FunctionGraph::Op::gop, *g, *g));\
+    }\
+    else\
+    {\
+        setGraph(FunctionGraph::binary(FunctionGraph::Op::gop, *getGraph(),\
+                                       *f.getGraph()));\
+    }\
     return *this;\
 }\
 DoubleFunction & DoubleFunction::operator op##=(const DoubleFunction  and f)\
@@ -223,27 +308,37 @@ DoubleFunction & DoubleFunction::operator op##=(const DoubleFunction  and f)\
     return *this;\
 }
 
-#define MAKE_SELF_SCALAR_OP(op)\
+#define MAKE_SELF_SCALAR_OP(op, gop)\
 DoubleFunction & DoubleFunction::operator op##=(const double x)\
 {\
-    DoubleFunction copy(*this);\
-    auto res = [x, copy](const double *arg){return copy(arg) op x;};\
-    setFunction(res, getNArg());\
+    setGraph(FunctionGraph::binary(FunctionGraph::Op::gop, *getGraph(), x));\
     return *this;\
 }\
 
-MAKE_SELF_FUNC_OP(+)
-MAKE_SELF_FUNC_OP(-)
-MAKE_SELF_FUNC_OP(*)
-MAKE_SELF_FUNC_OP(/)
-MAKE_SELF_SCALAR_OP(+)
-MAKE_SELF_SCALAR_OP(-)
-MAKE_SELF_SCALAR_OP(*)
-MAKE_SELF_SCALAR_OP(/)
+MAKE_SELF_FUNC_OP(+, add)
+MAKE_SELF_FUNC_OP(-, sub)
+MAKE_SELF_FUNC_OP(*, mul)
+MAKE_SELF_FUNC_OP(/, div)
+MAKE_SELF_SCALAR_OP(+, add)
+MAKE_SELF_SCALAR_OP(-, sub)
+MAKE_SELF_SCALAR_OP(*, mul)
+MAKE_SELF_SCALAR_OP(/, div)
+
+DoubleFunction Latan::operator/(const double lhs, const DoubleFunction &rhs)
+{
+    DoubleFunction resFunc;
+
+    resFunc.setGraph(FunctionGraph::binary(FunctionGraph::Op::div, lhs,
+                                           *rhs.getGraph()));
+
+    return resFunc;
+}
 
 /******************************************************************************
  *                    DoubleFunctionSample implementation                     *
  ******************************************************************************/
+atomic<unsigned int> DoubleFunctionSample::nThread_{1};
+
 // constructors ////////////////////////////////////////////////////////////////
 DoubleFunctionSample::DoubleFunctionSample(void)
 : Sample<DoubleFunction>()
@@ -253,14 +348,111 @@ DoubleFunctionSample::DoubleFunctionSample(const Index nSample)
 : Sample<DoubleFunction>(nSample)
 {}
 
+// parallel evaluation /////////////////////////////////////////////////////////
+unsigned int DoubleFunctionSample::getNThread(void)
+{
+    return nThread_;
+}
+
+void DoubleFunctionSample::setNThread(const unsigned int nThread)
+{
+    if (nThread > 0)
+    {
+        nThread_ = nThread;
+    }
+    else
+    {
+        nThread_ = std::max(thread::hardware_concurrency(), 1u);
+    }
+}
+
+// each thread handles a contiguous block of samples, the exceptions thrown by
+// the workers are rethrown in the calling thread
+void DoubleFunctionSample::forEachSample(const SampleFunc &body) const
+{
+    const Index first = -offset, n = size() + offset;
+    const Index nt    = std::min(static_cast<Index>(getNThread()), n);
+
+    if (nt <= 1)
+    {
+        FOR_STAT_ARRAY(*this, s)
+        {
+            body(s);
+        }
+    }
+    else
+    {
+        vector<thread>        worker;
+        vector<exception_ptr> error(nt);
+
+        for (Index t = 0; t < nt; ++t)
+        {
+            const Index begin = first + t*n/nt, end = first + (t + 1)*n/nt;
+
+            worker.emplace_back([&body, &error, t, begin, end](void)
+            {
+                try
+                {
+                    for (Index s = begin; s < end; ++s)
+                    {
+                        body(s);
+                    }
+                }
+                catch (...)
+                {
+                    error[t] = current_exception();
+                }
+            });
+        }
+        for (auto &w: worker)
+        {
+            w.join();
+        }
+        for (auto &e: error)
+        {
+            if (e)
+            {
+                rethrow_exception(e);
+            }
+        }
+    }
+}
+
 // function call ///////////////////////////////////////////////////////////////
 DSample DoubleFunctionSample::operator()(const DMatSample &arg) const
 {
     DSample result(size());
-    
+    bool    isBatch = (*this)[central].hasBatchFunction();
+
+    result.setResampling(getResampling());
+    // if all the samples share the same batch function (e.g. copies of the
+    // same compiled function), they are evaluated in a single batched call
     FOR_STAT_ARRAY((*this), s)
     {
-        result[s] = (*this)[s](arg[s]);
+        isBatch = isBatch and ((*this)[s].batch_ == (*this)[central].batch_)
+                  and (arg[s].size() == (*this)[s].getNArg());
+    }
+    if (isBatch)
+    {
+        const Index nArg = (*this)[central].getNArg();
+        const Index nPt  = size() + result.offset;
+        DMat        x(nPt, nArg);
+
+        FOR_STAT_ARRAY((*this), s)
+        {
+            for (Index i = 0; i < nArg; ++i)
+            {
+                x(s + result.offset, i) = arg[s](i);
+            }
+        }
+        (*this)[central](result.data(), x.data(), nPt);
+    }
+    else
+    {
+        forEachSample([this, &result, &arg](const Index s)
+        {
+            result[s] = (*this)[s](arg[s]);
+        });
     }
     
     return result;
@@ -270,10 +462,11 @@ DSample DoubleFunctionSample::operator()(const double *arg) const
 {
     DSample result(size());
     
-    FOR_STAT_ARRAY((*this), s)
+    result.setResampling(getResampling());
+    forEachSample([this, &result, arg](const Index s)
     {
         result[s] = (*this)[s](arg);
-    }
+    });
     
     return result;
 }
@@ -294,10 +487,11 @@ DoubleFunctionSample DoubleFunctionSample::bind(const Index argIndex,
 {
     DoubleFunctionSample bindFunc(size());
 
-    FOR_STAT_ARRAY(bindFunc, s)
+    bindFunc.setResampling(getResampling());
+    forEachSample([this, &bindFunc, argIndex, val](const Index s)
     {
         bindFunc[s] = (*this)[s].bind(argIndex, val);
-    }
+    });
 
     return bindFunc;
 }
@@ -307,10 +501,25 @@ DoubleFunctionSample DoubleFunctionSample::bind(const Index argIndex,
 {
     DoubleFunctionSample bindFunc(size());
 
-    FOR_STAT_ARRAY(bindFunc, s)
+    bindFunc.setResampling(getResampling());
+    forEachSample([this, &bindFunc, argIndex, &x](const Index s)
     {
         bindFunc[s] = (*this)[s].bind(argIndex, x);
-    }
+    });
 
     return bindFunc;
 }
+
+// sample //////////////////////////////////////////////////////////////////////
+DMatSample DoubleFunctionSample::sample(const DMat &x) const
+{
+    DMatSample result(size(), x.rows(), 1);
+
+    result.setResampling(getResampling());
+    forEachSample([this, &result, &x](const Index s)
+    {
+        result[s] = (*this)[s].sample(x);
+    });
+
+    return result;
+}
@@ -26,14 +26,22 @@
 
 BEGIN_LATAN_NAMESPACE
 
+class FunctionGraph;
+
 /******************************************************************************
  *                            Double function class                           *
  ******************************************************************************/
 class DoubleFunction
 {
+    friend class DoubleFunctionSample;
+    friend DoubleFunction operator/(const double lhs,
+                                    const DoubleFunction &rhs);
 private:
     // function type
     typedef std::function<double(const double *)> vecFunc;
+    typedef std::function<void(double *, const double *, const Index)>
+        batchFunc;
+    typedef std::function<void(double *, const double *)> gradFunc;
 public:
     // constructor
     explicit DoubleFunction(const vecFunc &f = nullptr, const Index nArg = 0);
@@ -42,6 +50,10 @@ public:
     // access
     virtual Index     getNArg(void) const;
             void      setFunction(const vecFunc &f, const Index nArg);
+            void      setBatchFunction(const batchFunc &f);
+            bool      hasBatchFunction(void) const;
+            void      setGradientFunction(const gradFunc &f);
+            bool      hasGradientFunction(void) const;
             VarName & varName(void);
     const   VarName & varName(void) const;
     // function call
@@ -53,6 +65,12 @@ public:
     template <typename... Ts>
     double operator()(const double arg0, const Ts... args) const;
     std::map<double, double> operator()(const std::map<double, double> &m) const;
+    // batched call on nPoint argument vectors in struct-of-arrays layout,
+    // i.e. res[k] = f(arg[k], arg[nPoint + k], ...)
+    void operator()(double *res, const double *arg, const Index nPoint) const;
+    // gradient, grad[i] is the derivative with respect to the argument i
+    void gradient(double *grad, const double *arg) const;
+    DVec gradient(const DVec &arg) const;
     // bind
     DoubleFunction bind(const Index argIndex, const double val) const;
     DoubleFunction bind(const Index argIndex, const DVec &x) const;
@@ -75,10 +93,16 @@ public:
 private:
     // error checking
     void checkSize(const Index nPar) const;
+    // composition graph
+    std::shared_ptr<const FunctionGraph> getGraph(void) const;
+    void setGraph(const std::shared_ptr<const FunctionGraph> &graph);
 private:
-    std::shared_ptr<DVec> buffer_{nullptr};
-    VarName               varName_;
-    vecFunc               f_;
+    std::shared_ptr<DVec>                buffer_{nullptr};
+    VarName                              varName_;
+    vecFunc                              f_;
+    std::shared_ptr<batchFunc>           batch_{nullptr};
+    std::shared_ptr<gradFunc>            grad_{nullptr};
+    std::shared_ptr<const FunctionGraph> graph_{nullptr};
 };
 
 /******************************************************************************
@@ -145,20 +169,19 @@ inline DoubleFunction operator-(const double lhs, DoubleFunction rhs)
 }
 
 // special case for scalar/function
-inline DoubleFunction operator/(const double lhs, DoubleFunction rhs)
-{
-    auto res = [lhs, rhs](const double *arg){return lhs/rhs(arg);};
-    
-    rhs.setFunction(res, rhs.getNArg());
-    
-    return rhs;
-}
+DoubleFunction operator/(const double lhs, const DoubleFunction &rhs);
 
 /******************************************************************************
  *                      DoubleFunctionSample class                            *
  ******************************************************************************/
+// the samples are evaluated in parallel by getNThread() threads (1 by
+// default), each thread handling a contiguous block of samples, the results
+// do not depend on the number of threads; the functions must then be
+// thread-safe
 class DoubleFunctionSample: public Sample<DoubleFunction>
 {
+private:
+    typedef std::function<void(const Index)> SampleFunc;
 public:
     // constructors
     DoubleFunctionSample(void);
@@ -167,6 +190,9 @@ public:
                     Sample<DoubleFunction>, ArrayExpr)
     // destructor
     virtual ~DoubleFunctionSample(void) = default;
+    // parallel evaluation (0 threads means one per hardware thread)
+    static unsigned int getNThread(void);
+    static void         setNThread(const unsigned int nThread);
     // function call
     DSample operator()(const DMatSample &arg) const;
     DSample operator()(const double *arg) const;
@@ -177,6 +203,13 @@ public:
     // bind
     DoubleFunctionSample bind(const Index argIndex, const double val) const;
     DoubleFunctionSample bind(const Index argIndex, const DVec &x) const ;
+    // sample, the values of each sample on the points given by the rows of x
+    DMatSample sample(const DMat &x) const;
+private:
+    // parallel loop over the samples
+    void forEachSample(const SampleFunc &body) const;
+private:
+    static std::atomic<unsigned int> nThread_;
 };
 
 template <typename... Ts>
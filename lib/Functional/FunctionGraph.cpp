@@ -0,0 +1,430 @@
+/*
+ * FunctionGraph.cpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LatAnalyze/Functional/FunctionGraph.hpp>
+#include <LatAnalyze/includes.hpp>
+
+using namespace std;
+using namespace Latan;
+
+// graphs up to this size are evaluated in stack buffers
+#define GRAPH_STACK_SIZE 64
+
+/******************************************************************************
+ *                       FunctionGraph implementation                         *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+FunctionGraph::FunctionGraph(const vecFunc &f,
+                             const shared_ptr<batchFunc> &batch,
+                             const Index nArg)
+: nArg_(nArg)
+{
+    Leaf leaf;
+
+    leaf.f     = f;
+    leaf.batch = batch;
+    for (Index i = 0; i < nArg; ++i)
+    {
+        leaf.input.push_back(i);
+        leaf.val.push_back(0.);
+    }
+    updateLeaf(leaf);
+    leaf_.push_back(leaf);
+    push(Op::leaf, 0);
+}
+
+// access //////////////////////////////////////////////////////////////////////
+Index FunctionGraph::getNArg(void) const
+{
+    return nArg_;
+}
+
+Index FunctionGraph::getNNode(void) const
+{
+    return static_cast<Index>(node_.size());
+}
+
+Index FunctionGraph::getNLeaf(void) const
+{
+    return static_cast<Index>(leaf_.size());
+}
+
+// composition /////////////////////////////////////////////////////////////////
+// append the nodes and leaves of g, returns the index of its output node
+unsigned int FunctionGraph::append(const FunctionGraph &g)
+{
+    const unsigned int nodeOffset = static_cast<unsigned int>(node_.size());
+    const unsigned int leafOffset = static_cast<unsigned int>(leaf_.size());
+
+    for (auto &l: g.leaf_)
+    {
+        leaf_.push_back(l);
+        maxLeafNArg_ = max(maxLeafNArg_, static_cast<Index>(l.input.size()));
+    }
+    for (auto n: g.node_)
+    {
+        switch (n.op)
+        {
+            case Op::leaf:
+                n.a += leafOffset;
+                break;
+            case Op::constant:
+                break;
+            case Op::neg:
+                n.a += nodeOffset;
+                break;
+            default:
+                n.a += nodeOffset;
+                n.b += nodeOffset;
+                break;
+        }
+        node_.push_back(n);
+    }
+
+    return static_cast<unsigned int>(node_.size() - 1);
+}
+
+unsigned int FunctionGraph::push(const Op op, const unsigned int a,
+                                 const unsigned int b, const double val)
+{
+    node_.push_back({op, a, b, val});
+
+    return static_cast<unsigned int>(node_.size() - 1);
+}
+
+void FunctionGraph::updateLeaf(Leaf &leaf)
+{
+    leaf.isIdentity = (static_cast<Index>(leaf.input.size()) == nArg_);
+    for (unsigned int i = 0; i < leaf.input.size(); ++i)
+    {
+        leaf.isIdentity = leaf.isIdentity
+                          and (leaf.input[i] == static_cast<Index>(i));
+    }
+    maxLeafNArg_ = max(maxLeafNArg_, static_cast<Index>(leaf.input.size()));
+}
+
+FunctionGraph::Ptr FunctionGraph::unary(const Op op, const FunctionGraph &g)
+{
+    if (op != Op::neg)
+    {
+        LATAN_ERROR(Argument, "invalid unary operation");
+    }
+
+    FunctionGraph *res = new FunctionGraph;
+    unsigned int  a;
+
+    res->nArg_ = g.nArg_;
+    a          = res->append(g);
+    res->push(op, a);
+
+    return Ptr(res);
+}
+
+// the operands of f op f are only evaluated once
+FunctionGraph::Ptr FunctionGraph::binary(const Op op, const FunctionGraph &lhs,
+                                         const FunctionGraph &rhs)
+{
+    if ((op < Op::add) or (op > Op::div))
+    {
+        LATAN_ERROR(Argument, "invalid binary operation");
+    }
+    if (lhs.nArg_ != rhs.nArg_)
+    {
+        LATAN_ERROR(Size, "composed functions have different numbers of "
+                    "arguments (" + strFrom(lhs.nArg_) + " and "
+                    + strFrom(rhs.nArg_) + ")");
+    }
+
+    FunctionGraph *res = new FunctionGraph;
+    unsigned int  a, b;
+
+    res->nArg_ = lhs.nArg_;
+    a          = res->append(lhs);
+    b          = (&lhs == &rhs) ? a : res->append(rhs);
+    res->push(op, a, b);
+
+    return Ptr(res);
+}
+
+FunctionGraph::Ptr FunctionGraph::binary(const Op op, const FunctionGraph &lhs,
+                                         const double rhs)
+{
+    if ((op < Op::add) or (op > Op::div))
+    {
+        LATAN_ERROR(Argument, "invalid binary operation");
+    }
+
+    FunctionGraph *res = new FunctionGraph;
+    unsigned int  a, b;
+
+    res->nArg_ = lhs.nArg_;
+    a          = res->append(lhs);
+    b          = res->push(Op::constant, 0, 0, rhs);
+    res->push(op, a, b);
+
+    return Ptr(res);
+}
+
+FunctionGraph::Ptr FunctionGraph::binary(const Op op, const double lhs,
+                                         const FunctionGraph &rhs)
+{
+    if ((op < Op::add) or (op > Op::div))
+    {
+        LATAN_ERROR(Argument, "invalid binary operation");
+    }
+
+    FunctionGraph *res = new FunctionGraph;
+    unsigned int  a, b;
+
+    res->nArg_ = rhs.nArg_;
+    a          = res->push(Op::constant, 0, 0, lhs);
+    b          = res->append(rhs);
+    res->push(op, a, b);
+
+    return Ptr(res);
+}
+
+// bind ////////////////////////////////////////////////////////////////////////
+// binding only changes where the leaves read their arguments
+FunctionGraph::Ptr FunctionGraph::bind(const FunctionGraph &g,
+                                       const Index argIndex, const double val)
+{
+    if ((argIndex < 0) or (argIndex >= g.nArg_))
+    {
+        LATAN_ERROR(Range, "bound argument index out of range");
+    }
+
+    FunctionGraph *res = new FunctionGraph(g);
+
+    res->nArg_        = g.nArg_ - 1;
+    res->maxLeafNArg_ = 0;
+    for (auto &l: res->leaf_)
+    {
+        for (unsigned int i = 0; i < l.input.size(); ++i)
+        {
+            if (l.input[i] == argIndex)
+            {
+                l.input[i] = -1;
+                l.val[i]   = val;
+            }
+            else if (l.input[i] > argIndex)
+            {
+                l.input[i]--;
+            }
+        }
+        res->updateLeaf(l);
+    }
+
+    return Ptr(res);
+}
+
+FunctionGraph::Ptr FunctionGraph::bind(const FunctionGraph &g,
+                                       const Index argIndex, const DVec &x)
+{
+    if ((argIndex < 0) or (argIndex >= g.nArg_))
+    {
+        LATAN_ERROR(Range, "bound argument index out of range");
+    }
+    if (x.size() != g.nArg_)
+    {
+        LATAN_ERROR(Size, "bound argument vector has a wrong size (expected "
+                    + strFrom(g.nArg_) + ", got " + strFrom(x.size()) + ")");
+    }
+
+    FunctionGraph *res = new FunctionGraph(g);
+
+    res->nArg_        = 1;
+    res->maxLeafNArg_ = 0;
+    for (auto &l: res->leaf_)
+    {
+        for (unsigned int i = 0; i < l.input.size(); ++i)
+        {
+            if (l.input[i] == argIndex)
+            {
+                l.input[i] = 0;
+            }
+            else if (l.input[i] >= 0)
+            {
+                l.val[i]   = x(l.input[i]);
+                l.input[i] = -1;
+            }
+        }
+        res->updateLeaf(l);
+    }
+
+    return Ptr(res);
+}
+
+// evaluation //////////////////////////////////////////////////////////////////
+// the stack buffers make the evaluation reentrant (a leaf can itself evaluate
+// a graph) and thread-safe
+double FunctionGraph::operator()(const double *arg) const
+{
+    double         valBuf[GRAPH_STACK_SIZE], argBuf[GRAPH_STACK_SIZE];
+    vector<double> valHeap, argHeap;
+    double         *v = valBuf, *x = argBuf;
+
+    if (node_.size() > GRAPH_STACK_SIZE)
+    {
+        valHeap.resize(node_.size());
+        v = valHeap.data();
+    }
+    if (maxLeafNArg_ > GRAPH_STACK_SIZE)
+    {
+        argHeap.resize(maxLeafNArg_);
+        x = argHeap.data();
+    }
+    for (unsigned int i = 0; i < node_.size(); ++i)
+    {
+        const Node &n = node_[i];
+
+        switch (n.op)
+        {
+            case Op::leaf:
+            {
+                const Leaf &l = leaf_[n.a];
+
+                if (l.isIdentity)
+                {
+                    v[i] = l.f(arg);
+                }
+                else
+                {
+                    for (unsigned int j = 0; j < l.input.size(); ++j)
+                    {
+                        x[j] = (l.input[j] >= 0) ? arg[l.input[j]] : l.val[j];
+                    }
+                    v[i] = l.f(x);
+                }
+                break;
+            }
+            case Op::constant:
+                v[i] = n.val;
+                break;
+            case Op::neg:
+                v[i] = -v[n.a];
+                break;
+            case Op::add:
+                v[i] = v[n.a] + v[n.b];
+                break;
+            case Op::sub:
+                v[i] = v[n.a] - v[n.b];
+                break;
+            case Op::mul:
+                v[i] = v[n.a]*v[n.b];
+                break;
+            case Op::div:
+                v[i] = v[n.a]/v[n.b];
+                break;
+        }
+    }
+
+    return v[node_.size() - 1];
+}
+
+// each node is evaluated on all the points, leaves with a batch function
+// are called once on the whole point set
+void FunctionGraph::operator()(double *res, const double *arg,
+                               const Index nPoint) const
+{
+    const Index    nNode = static_cast<Index>(node_.size());
+    vector<double> v(nNode*nPoint), x, y;
+
+    for (Index i = 0; i < nNode; ++i)
+    {
+        const Node &n   = node_[i];
+        double     *vi  = v.data() + i*nPoint;
+        const double *a = v.data() + n.a*nPoint, *b = v.data() + n.b*nPoint;
+
+        switch (n.op)
+        {
+            case Op::leaf:
+            {
+                const Leaf  &l  = leaf_[n.a];
+                const Index nIn = static_cast<Index>(l.input.size());
+
+                if (l.batch and l.isIdentity)
+                {
+                    (*l.batch)(vi, arg, nPoint);
+                }
+                else if (l.batch)
+                {
+                    x.resize(nIn*nPoint);
+                    for (Index j = 0; j < nIn; ++j)
+                    {
+                        for (Index k = 0; k < nPoint; ++k)
+                        {
+                            x[j*nPoint + k] = (l.input[j] >= 0) ?
+                                arg[l.input[j]*nPoint + k] : l.val[j];
+                        }
+                    }
+                    (*l.batch)(vi, x.data(), nPoint);
+                }
+                else
+                {
+                    y.resize(nIn);
+                    for (Index k = 0; k < nPoint; ++k)
+                    {
+                        for (Index j = 0; j < nIn; ++j)
+                        {
+                            y[j] = (l.input[j] >= 0) ?
+                                arg[l.input[j]*nPoint + k] : l.val[j];
+                        }
+                        vi[k] = l.f(y.data());
+                    }
+                }
+                break;
+            }
+            case Op::constant:
+                fill(vi, vi + nPoint, n.val);
+                break;
+            case Op::neg:
+                for (Index k = 0; k < nPoint; ++k)
+                {
+                    vi[k] = -a[k];
+                }
+                break;
+            case Op::add:
+                for (Index k = 0; k < nPoint; ++k)
+                {
+                    vi[k] = a[k] + b[k];
+                }
+                break;
+            case Op::sub:
+                for (Index k = 0; k < nPoint; ++k)
+                {
+                    vi[k] = a[k] - b[k];
+                }
+                break;
+            case Op::mul:
+                for (Index k = 0; k < nPoint; ++k)
+                {
+                    vi[k] = a[k]*b[k];
+                }
+                break;
+            case Op::div:
+                for (Index k = 0; k < nPoint; ++k)
+                {
+                    vi[k] = a[k]/b[k];
+                }
+                break;
+        }
+    }
+    copy(v.end() - nPoint, v.end(), res);
+}
@@ -0,0 +1,111 @@
+/*
+ * FunctionGraph.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_FunctionGraph_hpp_
+#define Latan_FunctionGraph_hpp_
+
+#include <LatAnalyze/Global.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                    Function composition graph class                        *
+ ******************************************************************************/
+// flat expression graph of arithmetic operations over leaf functions, used by
+// DoubleFunction to represent compositions: the nodes are stored in
+// evaluation order and the composition of graphs copies their nodes, so that
+// a composed function is evaluated in a single pass over the nodes whatever
+// the depth of the composition; the leaves read their arguments either from
+// the graph arguments or from bound constants; graphs are immutable and can
+// be evaluated concurrently
+class FunctionGraph
+{
+public:
+    typedef std::function<double(const double *)> vecFunc;
+    typedef std::function<void(double *, const double *, const Index)>
+        batchFunc;
+    typedef std::shared_ptr<const FunctionGraph> Ptr;
+    enum class Op: unsigned char
+    {
+        leaf = 0,
+        constant,
+        neg,
+        add,
+        sub,
+        mul,
+        div
+    };
+private:
+    struct Node
+    {
+        Op           op;
+        unsigned int a, b;
+        double       val;
+    };
+    struct Leaf
+    {
+        vecFunc                    f;
+        std::shared_ptr<batchFunc> batch;
+        std::vector<Index>         input;
+        std::vector<double>        val;
+        bool                       isIdentity;
+    };
+public:
+    // constructor (graph with a single leaf)
+    FunctionGraph(const vecFunc &f, const std::shared_ptr<batchFunc> &batch,
+                  const Index nArg);
+    // destructor
+    ~FunctionGraph(void) = default;
+    // access
+    Index getNArg(void) const;
+    Index getNNode(void) const;
+    Index getNLeaf(void) const;
+    // composition
+    static Ptr unary(const Op op, const FunctionGraph &g);
+    static Ptr binary(const Op op, const FunctionGraph &lhs,
+                      const FunctionGraph &rhs);
+    static Ptr binary(const Op op, const FunctionGraph &lhs, const double rhs);
+    static Ptr binary(const Op op, const double lhs, const FunctionGraph &rhs);
+    // bind the argument argIndex to val, or all the arguments except
+    // argIndex to the values of x
+    static Ptr bind(const FunctionGraph &g, const Index argIndex,
+                    const double val);
+    static Ptr bind(const FunctionGraph &g, const Index argIndex,
+                    const DVec &x);
+    // evaluation
+    double operator()(const double *arg) const;
+    // batched evaluation, arg[i*nPoint + k] is the argument i of the point k
+    void   operator()(double *res, const double *arg,
+                      const Index nPoint) const;
+private:
+    FunctionGraph(void) = default;
+    // composition
+    unsigned int append(const FunctionGraph &g);
+    unsigned int push(const Op op, const unsigned int a = 0,
+                      const unsigned int b = 0, const double val = 0.);
+    void         updateLeaf(Leaf &leaf);
+private:
+    Index              nArg_{0}, maxLeafNArg_{0};
+    std::vector<Node>  node_;
+    std::vector<Leaf>  leaf_;
+};
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_FunctionGraph_hpp_
@@ -0,0 +1,236 @@
+/*
+ * MemoFunction.cpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LatAnalyze/Functional/MemoFunction.hpp>
+#include <LatAnalyze/includes.hpp>
+
+using namespace std;
+using namespace Latan;
+
+/******************************************************************************
+ *                       MemoFunction implementation                          *
+ ******************************************************************************/
+constexpr Index MemoFunction::defaultCapacity;
+
+// key hash and comparison /////////////////////////////////////////////////////
+// the keys are compared bitwise, so that NaN arguments are cached and 0. and
+// -0. are different keys
+size_t MemoFunction::KeyHash::operator()(const Key &key) const
+{
+    size_t   h = key.size();
+    uint64_t b;
+
+    for (auto x: key)
+    {
+        memcpy(&b, &x, sizeof(b));
+        h ^= hash<uint64_t>()(b) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    }
+
+    return h;
+}
+
+bool MemoFunction::KeyEqual::operator()(const Key &a, const Key &b) const
+{
+    return (a.size() == b.size())
+           and (memcmp(a.data(), b.data(), a.size()*sizeof(double)) == 0);
+}
+
+// constructor /////////////////////////////////////////////////////////////////
+MemoFunction::MemoFunction(const DoubleFunction &f, const Index capacity,
+                           const Eviction eviction)
+: f_(f)
+, cache_(new Cache)
+{
+    setCapacity(capacity);
+    setEviction(eviction);
+}
+
+// access //////////////////////////////////////////////////////////////////////
+Index MemoFunction::getCapacity(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    return cache_->capacity;
+}
+
+MemoFunction::Eviction MemoFunction::getEviction(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    return cache_->eviction;
+}
+
+Index MemoFunction::getSize(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    return static_cast<Index>(cache_->index.size());
+}
+
+void MemoFunction::setCapacity(const Index capacity)
+{
+    if (capacity < 1)
+    {
+        LATAN_ERROR(Argument, "memoized function cache capacity must be "
+                    "positive (got " + strFrom(capacity) + ")");
+    }
+
+    lock_guard<mutex> lock(cache_->mutex);
+
+    cache_->capacity = capacity;
+    shrink();
+}
+
+void MemoFunction::setEviction(const Eviction eviction)
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    cache_->eviction = eviction;
+}
+
+void MemoFunction::clear(void)
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    cache_->entry.clear();
+    cache_->index.clear();
+}
+
+// statistics //////////////////////////////////////////////////////////////////
+Index MemoFunction::getNHit(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    return cache_->nHit;
+}
+
+Index MemoFunction::getNMiss(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    return cache_->nMiss;
+}
+
+Index MemoFunction::getNEviction(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    return cache_->nEviction;
+}
+
+double MemoFunction::getHitRate(void) const
+{
+    lock_guard<mutex> lock(cache_->mutex);
+    Index             nCall = cache_->nHit + cache_->nMiss;
+
+    return (nCall > 0) ? static_cast<double>(cache_->nHit)/nCall : 0.;
+}
+
+void MemoFunction::resetStatistics(void)
+{
+    lock_guard<mutex> lock(cache_->mutex);
+
+    cache_->nHit      = 0;
+    cache_->nMiss     = 0;
+    cache_->nEviction = 0;
+}
+
+// cache eviction //////////////////////////////////////////////////////////////
+// the most recent entries are at the front of the list, the caller must hold
+// the cache lock
+void MemoFunction::shrink(void) const
+{
+    Cache &c = *cache_;
+
+    while (static_cast<Index>(c.entry.size()) > c.capacity)
+    {
+        c.index.erase(c.entry.back().key);
+        c.entry.pop_back();
+        c.nEviction++;
+    }
+}
+
+// function call ///////////////////////////////////////////////////////////////
+// concurrent misses on the same argument all call the function, only the
+// first result is stored
+double MemoFunction::operator()(const double *arg) const
+{
+    Cache  &c = *cache_;
+    Key    key(arg, arg + f_.getNArg());
+    double value;
+
+    {
+        lock_guard<mutex> lock(c.mutex);
+        auto              it = c.index.find(key);
+
+        if (it != c.index.end())
+        {
+            c.nHit++;
+            if (c.eviction == Eviction::lru)
+            {
+                c.entry.splice(c.entry.begin(), c.entry, it->second);
+            }
+
+            return it->second->value;
+        }
+        c.nMiss++;
+    }
+    value = f_(arg);
+    {
+        lock_guard<mutex> lock(c.mutex);
+
+        if (c.index.find(key) == c.index.end())
+        {
+            c.entry.push_front({key, value});
+            c.index[key] = c.entry.begin();
+            shrink();
+        }
+    }
+
+    return value;
+}
+
+// DoubleFunction factory //////////////////////////////////////////////////////
+// the hard copy shares the cache with this object, the statistics of the
+// returned function can then be read from it
+DoubleFunction MemoFunction::makeFunction(const bool makeHardCopy) const
+{
+    DoubleFunction res;
+
+    if (makeHardCopy)
+    {
+        MemoFunction copy(*this);
+
+        res.setFunction([copy](const double *x){return copy(x);},
+                        f_.getNArg());
+    }
+    else
+    {
+        res.setFunction([this](const double *x){return (*this)(x);},
+                        f_.getNArg());
+    }
+
+    return res;
+}
+
+DoubleFunction Latan::memoize(const DoubleFunction &f, const Index capacity,
+                              const MemoFunction::Eviction eviction)
+{
+    return MemoFunction(f, capacity, eviction).makeFunction();
+}
@@ -0,0 +1,106 @@
+/*
+ * MemoFunction.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_MemoFunction_hpp_
+#define Latan_MemoFunction_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Functional/Function.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                       memoized function class                              *
+ ******************************************************************************/
+// wraps a function with a bounded cache of its values, keyed on the exact
+// bits of the argument vector; when the cache is full an entry is evicted,
+// either the least recently used (lru) or the oldest one (fifo); the cache is
+// shared by the copies of the object and by the functions it makes, and can
+// be used concurrently (the wrapped function is called outside of the lock)
+class MemoFunction: public DoubleFunctionFactory
+{
+public:
+    enum class Eviction {lru, fifo};
+    static constexpr Index defaultCapacity = 1024;
+private:
+    typedef std::vector<double> Key;
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const;
+    };
+    struct KeyEqual
+    {
+        bool operator()(const Key &a, const Key &b) const;
+    };
+    struct Entry
+    {
+        Key    key;
+        double value;
+    };
+    typedef std::list<Entry>::iterator                          EntryIt;
+    typedef std::unordered_map<Key, EntryIt, KeyHash, KeyEqual> EntryMap;
+    struct Cache
+    {
+        std::mutex       mutex;
+        std::list<Entry> entry;
+        EntryMap         index;
+        Index            capacity;
+        Eviction         eviction;
+        Index            nHit{0}, nMiss{0}, nEviction{0};
+    };
+public:
+    // constructor
+    explicit MemoFunction(const DoubleFunction &f,
+                          const Index capacity = defaultCapacity,
+                          const Eviction eviction = Eviction::lru);
+    // destructor
+    virtual ~MemoFunction(void) = default;
+    // access
+    Index    getCapacity(void) const;
+    Eviction getEviction(void) const;
+    Index    getSize(void) const;
+    void     setCapacity(const Index capacity);
+    void     setEviction(const Eviction eviction);
+    void     clear(void);
+    // statistics
+    Index    getNHit(void) const;
+    Index    getNMiss(void) const;
+    Index    getNEviction(void) const;
+    double   getHitRate(void) const;
+    void     resetStatistics(void);
+    // function call
+    double operator()(const double *arg) const;
+    // factory
+    virtual DoubleFunction makeFunction(const bool makeHardCopy = true) const;
+private:
+    // remove entries until the size is at most the capacity
+    void shrink(void) const;
+private:
+    DoubleFunction         f_;
+    std::shared_ptr<Cache> cache_;
+};
+
+DoubleFunction memoize(const DoubleFunction &f,
+                       const Index capacity = MemoFunction::defaultCapacity,
+                       const MemoFunction::Eviction eviction =
+                           MemoFunction::Eviction::lru);
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_MemoFunction_hpp_
@@ -53,6 +53,105 @@ void DoubleModel::setFunction(const vecFunc &f, const Index nArg,
     size_->nArg = nArg;
     size_->nPar = nPar;
     f_          = f;
+    batch_.reset();
+    multi_.reset();
+    parBind_.reset();
+    parGrad_.reset();
+}
+
+// the batch function must compute the same values as the function set with
+// setFunction, the latter resets it
+void DoubleModel::setBatchFunction(const batchFunc &f)
+{
+    if (f)
+    {
+        batch_.reset(new batchFunc(f));
+    }
+    else
+    {
+        batch_.reset();
+    }
+}
+
+bool DoubleModel::hasBatchFunction(void) const
+{
+    return (batch_ != nullptr);
+}
+
+// the model can declare itself as the output number output of a function f
+// computing nOutput values at once, f(res, arg, par) writing them in res;
+// models sharing the same f can then be evaluated together (e.g. in a fit
+// with several models), the function set with setFunction resets it
+void DoubleModel::setMultiFunction(const shared_ptr<multiFunc> &f,
+                                   const Index nOutput, const Index output)
+{
+    if (f and ((output < 0) or (output >= nOutput)))
+    {
+        LATAN_ERROR(Range, "model output index out of range");
+    }
+    multi_        = f;
+    multiNOutput_ = f ? nOutput : 0;
+    multiOutput_  = f ? output : 0;
+}
+
+bool DoubleModel::hasMultiFunction(void) const
+{
+    return (multi_ != nullptr);
+}
+
+const shared_ptr<DoubleModel::multiFunc> &
+DoubleModel::getMultiFunction(void) const
+{
+    return multi_;
+}
+
+Index DoubleModel::getMultiNOutput(void) const
+{
+    return multiNOutput_;
+}
+
+Index DoubleModel::getMultiOutput(void) const
+{
+    return multiOutput_;
+}
+
+// f(par) must return the model with the parameters par, typically after
+// computing once the parts of the model which only depend on the parameters,
+// the function set with setFunction resets it
+void DoubleModel::setParBindFunction(const parBindFunc &f)
+{
+    if (f)
+    {
+        parBind_.reset(new parBindFunc(f));
+    }
+    else
+    {
+        parBind_.reset();
+    }
+}
+
+bool DoubleModel::hasParBindFunction(void) const
+{
+    return (parBind_ != nullptr);
+}
+
+// f(grad, arg, par) must write in grad the derivatives of the model with
+// respect to the parameters, the function set with setFunction resets it
+void DoubleModel::setParGradientFunction(const parGradFunc &f)
+{
+    if (f)
+    {
+        parGrad_.reset(new parGradFunc(f));
+    }
+    else
+    {
+        parGrad_.reset();
+    }
+}
+
+bool DoubleModel::hasParGradientFunction(void) const
+{
+    return (parGrad_ != nullptr);
 }
 
 VarName & DoubleModel::varName(void)
@@ -113,7 +212,74 @@ double DoubleModel::operator()(const double *data, const double *par) const
     return f_(data, par);
 }
 
+void DoubleModel::operator()(double *res, const double *arg, const double *par,
+                             const Index nPoint) const
+{
+    if (batch_)
+    {
+        (*batch_)(res, arg, par, nPoint);
+    }
+    else
+    {
+        DVec x(getNArg());
+        auto f = bindPar(par);
+
+        for (Index k = 0; k < nPoint; ++k)
+        {
+            FOR_VEC(x, i)
+            {
+                x(i) = arg[i*nPoint + k];
+            }
+            res[k] = f(x.data());
+        }
+    }
+}
+
+DVec DoubleModel::sample(const DMat &x, const DVec &par) const
+{
+    if (x.cols() != getNArg())
+    {
+        LATAN_ERROR(Size, "sampling point matrix and number of arguments "
+                    "mismatch (matrix has " + strFrom(x.cols())
+                    + ", number of arguments is " + strFrom(getNArg()) + ")");
+    }
+    checkSize(getNArg(), par.size());
+
+    DVec res(x.rows());
+
+    // DMat is column-major, each column is an argument over all points
+    (*this)(res.data(), x.data(), par.data(), x.rows());
+
+    return res;
+}
+
+// parameter gradient //////////////////////////////////////////////////////////
+void DoubleModel::parGradient(double *grad, const double *arg,
+                              const double *par) const
+{
+    if (!parGrad_)
+    {
+        LATAN_ERROR(Definition, "model has no parameter gradient");
+    }
+    (*parGrad_)(grad, arg, par);
+}
+
 // model bind //////////////////////////////////////////////////////////////////
+DoubleModel::argFunc DoubleModel::bindPar(const double *par) const
+{
+    if (parBind_)
+    {
+        return (*parBind_)(par);
+    }
+    else
+    {
+        vecFunc        f = f_;
+        vector<double> p(par, par + getNPar());
+
+        return [f, p](const double *x){return f(x, p.data());};
+    }
+}
+
 DoubleFunction DoubleModel::fixArg(const DVec &arg) const
 {
     DoubleModel copy(*this);
@@ -124,20 +290,34 @@ DoubleFunction DoubleModel::fixArg(const DVec &arg) const
     };
     auto modelBind    = bind(modelWithVec, arg, _1);
 
-    return DoubleFunction(modelBind, getNPar());
+    DoubleFunction res(modelBind, getNPar());
+
+    if (hasParGradientFunction())
+    {
+        res.setGradientFunction([copy, arg](double *g, const double *p)
+        {
+            copy.parGradient(g, arg.data(), p);
+        });
+    }
+
+    return res;
 }
 
 DoubleFunction DoubleModel::fixPar(const DVec &par) const
 {
-    DoubleModel copy(*this);
+    DoubleModel    copy(*this);
+    DoubleFunction res(bindPar(par.data()), getNArg());
 
-    auto modelWithVec = [copy](const double *x, const DVec &p)
+    if (hasBatchFunction())
     {
-        return copy(x, p.data());
-    };
-    auto modelBind    = bind(modelWithVec, _1, par);
+        res.setBatchFunction([copy, par](double *r, const double *x,
+                                         const Index nPoint)
+        {
+            copy(r, x, par.data(), nPoint);
+        });
+    }
 
-    return DoubleFunction(modelBind, getNArg());
+    return res;
 }
 
 DoubleFunction DoubleModel::toFunction(void) const
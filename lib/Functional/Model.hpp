@@ -33,6 +33,14 @@ class DoubleModel
 {
 public:
     typedef std::function<double(const double *, const double *)> vecFunc;
+    typedef std::function<void(double *, const double *, const double *,
+                               const Index)> batchFunc;
+    typedef std::function<void(double *, const double *,
+                               const double *)> multiFunc;
+    typedef std::function<double(const double *)>  argFunc;
+    typedef std::function<argFunc(const double *)> parBindFunc;
+    typedef std::function<void(double *, const double *,
+                               const double *)> parGradFunc;
 private:
     struct ModelSize{Index nArg, nPar;};
 public:
@@ -46,6 +54,18 @@ public:
     virtual Index     getNPar(void) const;
             void      setFunction(const vecFunc &f, const Index nArg,
                                   const Index nPar);
+            void      setBatchFunction(const batchFunc &f);
+            bool      hasBatchFunction(void) const;
+            void      setMultiFunction(const std::shared_ptr<multiFunc> &f,
+                                       const Index nOutput, const Index output);
+            bool      hasMultiFunction(void) const;
+            const std::shared_ptr<multiFunc> & getMultiFunction(void) const;
+            Index     getMultiNOutput(void) const;
+            Index     getMultiOutput(void) const;
+            void      setParBindFunction(const parBindFunc &f);
+            bool      hasParBindFunction(void) const;
+            void      setParGradientFunction(const parGradFunc &f);
+            bool      hasParGradientFunction(void) const;
             VarName & varName(void);
       const VarName & varName(void) const;
             VarName & parName(void);
@@ -55,6 +75,18 @@ public:
     double operator()(const std::vector<double> &data,
                       const std::vector<double> &par) const;
     double operator()(const double *data, const double *par) const;
+    // batched call on nPoint argument vectors in struct-of-arrays layout with
+    // fixed parameters, i.e. res[k] = f(arg[k], arg[nPoint + k], ...; par)
+    void operator()(double *res, const double *arg, const double *par,
+                    const Index nPoint) const;
+    // values on the points given by the rows of x
+    DVec sample(const DMat &x, const DVec &par) const;
+    // model with the parameters par bound, as a function of the arguments
+    // only, for evaluating many points with the same parameters
+    argFunc bindPar(const double *par) const;
+    // gradient with respect to the parameters, grad[j] is the derivative
+    // with respect to the parameter j
+    void parGradient(double *grad, const double *arg, const double *par) const;
     // bind
     DoubleFunction fixArg(const DVec &arg) const;
     DoubleFunction fixPar(const DVec &par) const;
@@ -63,9 +95,14 @@ private:
     // error checking
     void checkSize(const Index nArg, const Index nPar) const;
 private:
-    std::shared_ptr<ModelSize> size_;
-    VarName                    varName_, parName_;
-    vecFunc                    f_;
+    std::shared_ptr<ModelSize>   size_;
+    VarName                      varName_, parName_;
+    vecFunc                      f_;
+    std::shared_ptr<batchFunc>   batch_{nullptr};
+    std::shared_ptr<multiFunc>   multi_{nullptr};
+    std::shared_ptr<parBindFunc> parBind_{nullptr};
+    std::shared_ptr<parGradFunc> parGrad_{nullptr};
+    Index                        multiNOutput_{0}, multiOutput_{0};
 };
 
 /******************************************************************************
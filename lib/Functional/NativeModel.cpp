@@ -0,0 +1,717 @@
+/*
+ * NativeModel.cpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LatAnalyze/Functional/NativeModel.hpp>
+#include <LatAnalyze/Core/Math.hpp>
+#include <LatAnalyze/includes.hpp>
+#include <sys/stat.h>
+#ifdef HAVE_DLOPEN
+#include <dlfcn.h>
+#endif
+
+#ifndef CXX_COMMAND
+#define CXX_COMMAND "c++"
+#endif
+
+// increment when the generated code changes to invalidate the cache
+#define NATIVE_GENERATOR_VERSION 1
+
+using namespace std;
+using namespace Latan;
+
+/******************************************************************************
+ *                          C++ code generation                               *
+ ******************************************************************************/
+typedef map<string, string> SymbolTable;
+
+// double literal which round-trips exactly
+static string cppLiteral(const double x)
+{
+    if (std::isnan(x))
+    {
+        return "NAN";
+    }
+    else if (std::isinf(x))
+    {
+        return (x > 0.) ? "HUGE_VAL" : "(-HUGE_VAL)";
+    }
+    else
+    {
+        ostringstream out;
+        string        str;
+
+        out << setprecision(17) << x;
+        str = out.str();
+        if (str.find_first_of(".e") == string::npos)
+        {
+            str += ".";
+        }
+
+        return (x < 0.) ? "(" + str + ")" : str;
+    }
+}
+
+static string cppString(const string &str)
+{
+    string res = "\"";
+
+    for (auto c: str)
+    {
+        if ((c == '"') or (c == '\\'))
+        {
+            res += '\\';
+            res += c;
+        }
+        else if (c == '\n')
+        {
+            res += "\\n";
+        }
+        else
+        {
+            res += c;
+        }
+    }
+    res += "\"";
+
+    return res;
+}
+
+static string cppVariable(const string &name)
+{
+    return "v_" + name;
+}
+
+static void collectVariables(set<string> &name, const ExprNode &node)
+{
+    if (isDerivedFrom<VarNode>(&node))
+    {
+        name.insert(node.getName());
+    }
+    for (Index i = 0; i < node.getNArg(); ++i)
+    {
+        collectVariables(name, node[i]);
+    }
+}
+
+static void emitExpr(ostream &out, const ExprNode &node)
+{
+    auto &n = node;
+
+    if (isDerivedFrom<CstNode>(&n))
+    {
+        out << cppLiteral(dynamic_cast<const CstNode &>(n).getValue());
+    }
+    else if (isDerivedFrom<VarNode>(&n))
+    {
+        out << cppVariable(n.getName());
+    }
+    else if (isDerivedFrom<IntPowNode>(&n))
+    {
+        out << "latan_ipow(";
+        emitExpr(out, n[0]);
+        out << ", " << dynamic_cast<const CstNode &>(n[1]).getValue() << "u)";
+    }
+    else if (isDerivedFrom<MathOpNode>(&n))
+    {
+        if ((n.getName() == "-") and (n.getNArg() == 1))
+        {
+            out << "(-";
+            emitExpr(out, n[0]);
+            out << ")";
+        }
+        else if ((n.getName() == "^") and (n.getNArg() == 2))
+        {
+            out << "std::pow(";
+            emitExpr(out, n[0]);
+            out << ", ";
+            emitExpr(out, n[1]);
+            out << ")";
+        }
+        else if (n.getNArg() == 2)
+        {
+            out << "(";
+            emitExpr(out, n[0]);
+            out << " " << n.getName() << " ";
+            emitExpr(out, n[1]);
+            out << ")";
+        }
+        else
+        {
+            LATAN_ERROR(Compilation, "unknown operator '" + n.getName()
+                        + "'");
+        }
+    }
+    else if (isDerivedFrom<FuncNode>(&n))
+    {
+        // the run contexts of compiled models only contain the standard
+        // math builtins, which all have a std:: counterpart in <cmath>
+        out << "std::" << n.getName() << "(";
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            out << ((i > 0) ? ", " : "");
+            emitExpr(out, n[i]);
+        }
+        out << ")";
+    }
+    else
+    {
+        LATAN_ERROR(Compilation, "unexpected node '" + n.getName()
+                    + "' in expression");
+    }
+}
+
+// return true if a return statement was emitted
+static bool emitStatement(ostream &out, const ExprNode &node)
+{
+    auto &n = node;
+
+    if (isDerivedFrom<SemicolonNode>(&n))
+    {
+        for (Index i = 0; i < n.getNArg(); ++i)
+        {
+            if (emitStatement(out, n[i]))
+            {
+                return true;
+            }
+        }
+    }
+    else if (isDerivedFrom<AssignNode>(&n))
+    {
+        out << "    " << cppVariable(n[0].getName()) << " = ";
+        emitExpr(out, n[1]);
+        out << ";" << endl;
+    }
+    else if (isDerivedFrom<ReturnNode>(&n))
+    {
+        if (n.getNArg() != 1)
+        {
+            LATAN_ERROR(Compilation, "native models have a single output");
+        }
+        out << "    return ";
+        emitExpr(out, n[0]);
+        out << ";" << endl;
+
+        return true;
+    }
+
+    return false;
+}
+
+static string generateSource(const ExprNode &ast, const string &key,
+                             const Index nArg, const Index nPar)
+{
+    ostringstream out;
+    SymbolTable   init;
+    set<string>   name;
+
+    for (Index i = 0; i < nArg; ++i)
+    {
+        init["x_" + strFrom(i)] = "x[" + strFrom(i) + "]";
+    }
+    for (Index j = 0; j < nPar; ++j)
+    {
+        init["p_" + strFrom(j)] = "p[" + strFrom(j) + "]";
+    }
+    init["pi"]  = cppLiteral(Math::pi);
+    init["inf"] = cppLiteral(Math::inf);
+    collectVariables(name, ast);
+    out << "// " << Env::fullName << " native model, generated code" << endl;
+    out << "#include <cmath>" << endl << endl;
+    out << "extern \"C\" const char latan_native_key[] = " << cppString(key)
+        << ";" << endl << endl;
+    // same multiplication chain as the interpreter IntPowNode
+    out << "static inline double latan_ipow(const double x, "
+        << "const unsigned int n)" << endl;
+    out << "{" << endl;
+    out << "    unsigned int bit;" << endl;
+    out << "    double       r = x;" << endl << endl;
+    out << "    for (bit = 1; (bit << 1) <= n; bit <<= 1);" << endl;
+    out << "    for (bit >>= 1; bit > 0; bit >>= 1)" << endl;
+    out << "    {" << endl;
+    out << "        r *= r;" << endl;
+    out << "        if (n & bit)" << endl;
+    out << "        {" << endl;
+    out << "            r *= x;" << endl;
+    out << "        }" << endl;
+    out << "    }" << endl << endl;
+    out << "    return r;" << endl;
+    out << "}" << endl << endl;
+    out << "static inline double latan_eval(const double *x, const double *p)"
+        << endl;
+    out << "{" << endl;
+    out << "    (void)x;" << endl;
+    out << "    (void)p;" << endl;
+    for (auto &v: name)
+    {
+        auto it = init.find(v);
+
+        out << "    double " << cppVariable(v) << " = "
+            << ((it != init.end()) ? it->second : "0.") << ";" << endl;
+    }
+    if (!emitStatement(out, ast))
+    {
+        LATAN_ERROR(Syntax, "expected 'return' in program");
+    }
+    out << "}" << endl << endl;
+    out << "extern \"C\" double latan_native_eval(const double *x, "
+        << "const double *p)" << endl;
+    out << "{" << endl;
+    out << "    return latan_eval(x, p);" << endl;
+    out << "}" << endl << endl;
+    out << "extern \"C\" void latan_native_batch(double *res, const double *x,"
+        << " const double *p, const long n)" << endl;
+    out << "{" << endl;
+    out << "    double xk[" << max(nArg, static_cast<Index>(1)) << "];"
+        << endl << endl;
+    out << "    for (long k = 0; k < n; ++k)" << endl;
+    out << "    {" << endl;
+    out << "        for (long i = 0; i < " << nArg << "; ++i)" << endl;
+    out << "        {" << endl;
+    out << "            xk[i] = x[i*n + k];" << endl;
+    out << "        }" << endl;
+    out << "        res[k] = latan_eval(xk, p);" << endl;
+    out << "    }" << endl;
+    out << "}" << endl;
+
+    return out.str();
+}
+
+// 64-bit FNV-1a hash, stable across platforms and runs
+static string fnvHash(const string &str)
+{
+    unsigned long long h = 14695981039346656037ull;
+    ostringstream      out;
+
+    for (auto c: str)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    out << hex << setw(16) << setfill('0') << h;
+
+    return out.str();
+}
+
+static string getEnv(const string &name, const string &def)
+{
+    const char *val = getenv(name.c_str());
+
+    return (val and (val[0] != '\0')) ? string(val) : def;
+}
+
+static string shellQuote(const string &str)
+{
+    string res = "'";
+
+    for (auto c: str)
+    {
+        res += (c == '\'') ? string("'\\''") : string(1, c);
+    }
+    res += "'";
+
+    return res;
+}
+
+// only objects in a private directory or file belonging to the current user
+// are trusted, since loading a shared object executes its code
+static bool isPrivate(const string &path, const bool isDirectory)
+{
+    struct stat st;
+
+    if (lstat(path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+
+    return (isDirectory ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode))
+           and (st.st_uid == geteuid())
+           and ((st.st_mode & (S_IRWXG|S_IRWXO)) == 0);
+}
+
+/******************************************************************************
+ *                    NativeDoubleModel implementation                        *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+NativeDoubleModel::NativeDoubleModel(const string &code, const Index nArg,
+                                     const Index nPar)
+: nArg_(nArg)
+, nPar_(nPar)
+, code_(code)
+, fallback_(code, nArg, nPar)
+{
+    load();
+}
+
+// access //////////////////////////////////////////////////////////////////////
+Index NativeDoubleModel::getNArg(void) const
+{
+    return nArg_;
+}
+
+Index NativeDoubleModel::getNPar(void) const
+{
+    return nPar_;
+}
+
+string NativeDoubleModel::getCode(void) const
+{
+    return code_;
+}
+
+bool NativeDoubleModel::isNative(void) const
+{
+    return (eval_ != nullptr);
+}
+
+// an empty string is returned if there is no per-user cache directory
+string NativeDoubleModel::getCacheDirectory(void)
+{
+    const string home = getEnv("HOME", "");
+
+    return getEnv("LATAN_NATIVE_CACHE",
+                  home.empty() ? "" : home + "/.cache/LatAnalyze");
+}
+
+string NativeDoubleModel::getKey(void) const
+{
+    return "generator " + strFrom(NATIVE_GENERATOR_VERSION) + "; nArg "
+           + strFrom(nArg_) + "; nPar " + strFrom(nPar_) + "; code " + code_;
+}
+
+// generated C++ source ////////////////////////////////////////////////////////
+string NativeDoubleModel::getSource(void) const
+{
+    vector<string> varName;
+
+    for (Index i = 0; i < nArg_; ++i)
+    {
+        varName.push_back("x_" + strFrom(i));
+    }
+    for (Index j = 0; j < nPar_; ++j)
+    {
+        varName.push_back("p_" + strFrom(j));
+    }
+
+    // compiling the program checks it and produces the optimized AST
+    CompiledProgram       program(code_, varName);
+    const MathInterpreter &interpreter = program.getInterpreter();
+    const ExprNode        *ast = interpreter.getOptimizedAST();
+
+    if (!ast)
+    {
+        ast = interpreter.getAST();
+    }
+
+    return generateSource(*ast, getKey(), nArg_, nPar_);
+}
+
+// shared object loading ///////////////////////////////////////////////////////
+void NativeDoubleModel::load(void)
+{
+#ifdef HAVE_DLOPEN
+    string dir  = getCacheDirectory();
+    string path = dir + "/" + fnvHash(getKey()) + ".so";
+
+    if (dir.empty())
+    {
+        LATAN_WARNING("no native code cache directory (HOME and "
+                      "LATAN_NATIVE_CACHE are not set), falling back to the "
+                      "interpreter");
+
+        return;
+    }
+    // the last component is created private, the parents are left as they are
+    if (access(dir.c_str(), F_OK) != 0)
+    {
+        const size_t pos = dir.find_last_of('/');
+
+        if ((pos != string::npos) and (pos > 0))
+        {
+            Latan::mkdir(dir.substr(0, pos));
+        }
+        ::mkdir(dir.c_str(), S_IRWXU);
+    }
+    if (!isPrivate(dir, true))
+    {
+        LATAN_WARNING("native code cache directory '" + dir + "' is missing "
+                      "or is not a private directory of the current user, "
+                      "falling back to the interpreter");
+    }
+    else if (isPrivate(path, false) and loadObject(path))
+    {
+        return;
+    }
+    else if (buildObject(path) and isPrivate(path, false) and loadObject(path))
+    {
+        return;
+    }
+    else
+    {
+        LATAN_WARNING("native compilation failed, falling back to the "
+                      "interpreter");
+    }
+#else
+    LATAN_WARNING("native code generation is not available (dlopen not "
+                  "found), falling back to the interpreter");
+#endif
+}
+
+bool NativeDoubleModel::loadObject(const string &path)
+{
+#ifdef HAVE_DLOPEN
+    void *handle = dlopen(path.c_str(), RTLD_NOW|RTLD_LOCAL);
+
+    if (!handle)
+    {
+        return false;
+    }
+
+    auto key   = static_cast<const char *>(dlsym(handle, "latan_native_key"));
+    auto eval  = reinterpret_cast<EvalFunc>(dlsym(handle,
+                                                  "latan_native_eval"));
+    auto batch = reinterpret_cast<BatchFunc>(dlsym(handle,
+                                                   "latan_native_batch"));
+
+    // the key check protects against hash collisions and stale objects
+    if (!key or !eval or !batch or (getKey() != key))
+    {
+        dlclose(handle);
+
+        return false;
+    }
+    handle_.reset(handle, [](void *h){dlclose(h);});
+    eval_  = eval;
+    batch_ = batch;
+
+    return true;
+#else
+    (void)path;
+
+    return false;
+#endif
+}
+
+// the object is built under a unique temporary name and then renamed, so that
+// concurrent builds (threads or processes) never see a partial file
+bool NativeDoubleModel::buildObject(const string &path) const
+{
+    string source, command;
+    string stem  = path.substr(0, path.find_last_of('.'));
+    string tmp   = stem + ".XXXXXX.cpp";
+    string cxx   = getEnv("LATAN_NATIVE_CXX", CXX_COMMAND);
+    string flags = getEnv("LATAN_NATIVE_CXXFLAGS", "-O2");
+    int    fd, status;
+
+    // the code generator does not support every program the interpreter runs
+    try
+    {
+        source = getSource();
+    }
+    catch (const Exceptions::Compilation &e)
+    {
+        LATAN_WARNING("native code generation failed: " + string(e.what()));
+
+        return false;
+    }
+    catch (const Exceptions::Syntax &e)
+    {
+        LATAN_WARNING("native code generation failed: " + string(e.what()));
+
+        return false;
+    }
+    // mkstemps creates the source file exclusively under an unpredictable name
+    fd = mkstemps(&tmp[0], 4);
+    if (fd < 0)
+    {
+        return false;
+    }
+    status = (write(fd, source.data(), source.size())
+              == static_cast<ssize_t>(source.size())) ? 0 : -1;
+    close(fd);
+    tmp.resize(tmp.size() - 4);
+    if (status != 0)
+    {
+        remove((tmp + ".cpp").c_str());
+
+        return false;
+    }
+    command = cxx + " " + flags + " -fPIC -shared -o "
+              + shellQuote(tmp + ".so") + " " + shellQuote(tmp + ".cpp")
+              + " > " + shellQuote(tmp + ".log") + " 2>&1";
+    status  = system(command.c_str());
+    if (status != 0)
+    {
+        // the source and the log are kept for inspection
+        LATAN_WARNING("native compilation command '" + command
+                      + "' failed (log in '" + tmp + ".log')");
+        remove((tmp + ".so").c_str());
+
+        return false;
+    }
+    remove((tmp + ".log").c_str());
+    chmod((tmp + ".so").c_str(), S_IRWXU);
+    rename((tmp + ".cpp").c_str(), (stem + ".cpp").c_str());
+
+    return (rename((tmp + ".so").c_str(), path.c_str()) == 0);
+}
+
+// function call ///////////////////////////////////////////////////////////////
+double NativeDoubleModel::operator()(const double *arg,
+                                     const double *par) const
+{
+    return eval_ ? eval_(arg, par) : fallback_(arg, par);
+}
+
+void NativeDoubleModel::operator()(double *res, const double *arg,
+                                   const double *par, const Index nPoint) const
+{
+    if (batch_)
+    {
+        batch_(res, arg, par, static_cast<long>(nPoint));
+    }
+    else
+    {
+        fallback_(res, arg, par, nPoint);
+    }
+}
+
+// DoubleModel factory /////////////////////////////////////////////////////////
+DoubleModel NativeDoubleModel::makeModel(const bool makeHardCopy) const
+{
+    // the interpreter model provides the same hooks as CompiledDoubleModel
+    if (!isNative())
+    {
+        return fallback_.makeModel(makeHardCopy);
+    }
+
+    DoubleModel res;
+
+    // native code is cheaper than the interpreter prelude/body split, so
+    // binding the parameters just captures them for the native function
+    if (makeHardCopy)
+    {
+        NativeDoubleModel copy(*this);
+
+        res.setFunction([copy](const double *x, const double *p)
+                        {return copy(x, p);}, nArg_, nPar_);
+        res.setBatchFunction([copy](double *r, const double *x,
+                                    const double *p, const Index n)
+                             {copy(r, x, p, n);});
+        res.setParGradientFunction([copy](double *g, const double *x,
+                                          const double *p)
+                                   {copy.fallback_.parGradient(g, x, p);});
+    }
+    else
+    {
+        res.setFunction([this](const double *x, const double *p)
+                        {return (*this)(x, p);}, nArg_, nPar_);
+        res.setBatchFunction([this](double *r, const double *x,
+                                    const double *p, const Index n)
+                             {(*this)(r, x, p, n);});
+        res.setParGradientFunction([this](double *g, const double *x,
+                                          const double *p)
+                                   {fallback_.parGradient(g, x, p);});
+    }
+
+    auto        handle = handle_;
+    auto        eval   = eval_;
+    const Index nPar   = nPar_;
+
+    res.setParBindFunction([handle, eval, nPar](const double *par)
+    {
+        vector<double> p(par, par + nPar);
+
+        return DoubleModel::argFunc([handle, eval, p](const double *x)
+                                    {return eval(x, p.data());});
+    });
+
+    return res;
+}
+
+DoubleModel Latan::compileNative(const string &code, const Index nArg,
+                                 const Index nPar)
+{
+    NativeDoubleModel nativeModel(code, nArg, nPar);
+
+    return nativeModel.makeModel();
+}
+
+/******************************************************************************
+ *                   NativeDoubleFunction implementation                      *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+NativeDoubleFunction::NativeDoubleFunction(const string &code,
+                                           const Index nArg)
+: model_(code, nArg, 0)
+{}
+
+// access //////////////////////////////////////////////////////////////////////
+string NativeDoubleFunction::getCode(void) const
+{
+    return model_.getCode();
+}
+
+bool NativeDoubleFunction::isNative(void) const
+{
+    return model_.isNative();
+}
+
+// function call ///////////////////////////////////////////////////////////////
+double NativeDoubleFunction::operator()(const double *arg) const
+{
+    return model_(arg, nullptr);
+}
+
+void NativeDoubleFunction::operator()(double *res, const double *arg,
+                                      const Index nPoint) const
+{
+    model_(res, arg, nullptr, nPoint);
+}
+
+// DoubleFunction factory //////////////////////////////////////////////////////
+DoubleFunction NativeDoubleFunction::makeFunction(const bool makeHardCopy)
+                                                  const
+{
+    DoubleFunction res;
+    const Index    nArg = model_.getNArg();
+
+    if (makeHardCopy)
+    {
+        NativeDoubleFunction copy(*this);
+
+        res.setFunction([copy](const double *x){return copy(x);}, nArg);
+        res.setBatchFunction([copy](double *r, const double *x,
+                                    const Index n){copy(r, x, n);});
+    }
+    else
+    {
+        res.setFunction([this](const double *x){return (*this)(x);}, nArg);
+        res.setBatchFunction([this](double *r, const double *x,
+                                    const Index n){(*this)(r, x, n);});
+    }
+
+    return res;
+}
+
+DoubleFunction Latan::compileNative(const string &code, const Index nArg)
+{
+    NativeDoubleFunction nativeFunc(code, nArg);
+
+    return nativeFunc.makeFunction();
+}
@@ -0,0 +1,117 @@
+/*
+ * NativeModel.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_NativeModel_hpp_
+#define Latan_NativeModel_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Functional/CompiledFunction.hpp>
+#include <LatAnalyze/Functional/CompiledModel.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                     native double model class                              *
+ ******************************************************************************/
+// The program is translated to C++, compiled into a shared object with the
+// system compiler and loaded with dlopen. Shared objects are cached on disk,
+// keyed by a hash of the code and of the number of arguments and parameters.
+// If anything fails the model falls back to the interpreter, which is always
+// the case if LatAnalyze was built without dlopen. The cache directory must be
+// owned by the current user and not accessible to others (it is created with
+// mode 0700), otherwise native code generation is disabled.
+// Environment variables:
+// - LATAN_NATIVE_CXX     : compiler command (default: compiler used to build
+//                          LatAnalyze)
+// - LATAN_NATIVE_CXXFLAGS: compiler flags (default: -O2)
+// - LATAN_NATIVE_CACHE   : cache directory (default: $HOME/.cache/LatAnalyze,
+//                          native code generation is disabled if neither
+//                          variable is set)
+class NativeDoubleModel: public DoubleModelFactory
+{
+public:
+    typedef double (*EvalFunc)(const double *, const double *);
+    typedef void (*BatchFunc)(double *, const double *, const double *,
+                              const long);
+public:
+    // constructor
+    NativeDoubleModel(const std::string &code, const Index nArg,
+                      const Index nPar);
+    // destructor
+    virtual ~NativeDoubleModel(void) = default;
+    // access
+    Index       getNArg(void) const;
+    Index       getNPar(void) const;
+    std::string getCode(void) const;
+    bool        isNative(void) const;
+    // generated C++ source
+    std::string getSource(void) const;
+    // function call
+    double operator()(const double *arg, const double *par) const;
+    void   operator()(double *res, const double *arg, const double *par,
+                      const Index nPoint) const;
+    // factory
+    DoubleModel makeModel(const bool makeHardCopy = true) const;
+    // cache
+    static std::string getCacheDirectory(void);
+private:
+    // cache key and shared object loading
+    std::string getKey(void) const;
+    void        load(void);
+    bool        loadObject(const std::string &path);
+    bool        buildObject(const std::string &path) const;
+private:
+    Index                 nArg_, nPar_;
+    std::string           code_;
+    std::shared_ptr<void> handle_{nullptr};
+    EvalFunc              eval_{nullptr};
+    BatchFunc             batch_{nullptr};
+    CompiledDoubleModel   fallback_;
+};
+
+/******************************************************************************
+ *                     native double function class                           *
+ ******************************************************************************/
+class NativeDoubleFunction: public DoubleFunctionFactory
+{
+public:
+    // constructor
+    NativeDoubleFunction(const std::string &code, const Index nArg);
+    // destructor
+    virtual ~NativeDoubleFunction(void) = default;
+    // access
+    std::string getCode(void) const;
+    bool        isNative(void) const;
+    // function call
+    double operator()(const double *arg) const;
+    void   operator()(double *res, const double *arg, const Index nPoint) const;
+    // factory
+    virtual DoubleFunction makeFunction(const bool makeHardCopy = true) const;
+private:
+    NativeDoubleModel model_;
+};
+
+// DoubleModel and DoubleFunction factories
+DoubleModel    compileNative(const std::string &code, const Index nArg,
+                             const Index nPar);
+DoubleFunction compileNative(const std::string &code, const Index nArg);
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_NativeModel_hpp_
@@ -0,0 +1,204 @@
+/*
+ * StaticModel.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_StaticModel_hpp_
+#define Latan_StaticModel_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Functional/Model.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                  model with compile-time dimensions                        *
+ ******************************************************************************/
+// CRTP base for models with numbers of arguments and parameters fixed at
+// compile time, Impl must provide the inline member functions
+//   double value(const double *x, const double *p) const;
+//   void   gradient(double *g, const double *x, const double *p) const;
+// and can provide
+//   void   setNames(DoubleModel &model) const;
+// The evaluation is then inlined in the fixed-size vector interface and in
+// the batched loop over points, the conversion to DoubleModel installs this
+// loop as batch function, so that the fitters pay one indirect call per
+// model and per chi^2 evaluation instead of one per point.
+template <typename Impl, Index nArg, Index nPar>
+class StaticModel: public DoubleModelFactory
+{
+public:
+    typedef SDVec<nArg> ArgVec;
+    typedef SDVec<nPar> ParVec;
+public:
+    // constructor
+    StaticModel(void) = default;
+    // destructor
+    virtual ~StaticModel(void) = default;
+    // access
+    static constexpr Index getNArg(void);
+    static constexpr Index getNPar(void);
+    // function call
+    double operator()(const double *arg, const double *par) const;
+    double operator()(const ArgVec &arg, const ParVec &par) const;
+    // batched call in struct-of-arrays layout, cf. DoubleModel
+    void   operator()(double *res, const double *arg, const double *par,
+                      const Index nPoint) const;
+    // gradient with respect to the parameters
+    void   parGradient(double *grad, const double *arg,
+                       const double *par) const;
+    ParVec parGradient(const ArgVec &arg, const ParVec &par) const;
+    // factory
+    virtual DoubleModel makeModel(const bool makeHardCopy = true) const;
+    operator DoubleModel(void) const;
+    // default (empty) names
+    void setNames(DoubleModel &model) const;
+private:
+    const Impl & impl(void) const;
+};
+
+/******************************************************************************
+ *                   StaticModel template implementation                      *
+ ******************************************************************************/
+// access //////////////////////////////////////////////////////////////////////
+template <typename Impl, Index nArg, Index nPar>
+constexpr Index StaticModel<Impl, nArg, nPar>::getNArg(void)
+{
+    return nArg;
+}
+
+template <typename Impl, Index nArg, Index nPar>
+constexpr Index StaticModel<Impl, nArg, nPar>::getNPar(void)
+{
+    return nPar;
+}
+
+template <typename Impl, Index nArg, Index nPar>
+inline const Impl & StaticModel<Impl, nArg, nPar>::impl(void) const
+{
+    return static_cast<const Impl &>(*this);
+}
+
+template <typename Impl, Index nArg, Index nPar>
+void StaticModel<Impl, nArg, nPar>::setNames(DoubleModel &model __dumb) const
+{}
+
+// function call ///////////////////////////////////////////////////////////////
+template <typename Impl, Index nArg, Index nPar>
+inline double StaticModel<Impl, nArg, nPar>::operator()(const double *arg,
+                                                        const double *par)
+const
+{
+    return impl().value(arg, par);
+}
+
+template <typename Impl, Index nArg, Index nPar>
+inline double StaticModel<Impl, nArg, nPar>::operator()(const ArgVec &arg,
+                                                        const ParVec &par)
+const
+{
+    return impl().value(arg.data(), par.data());
+}
+
+// the parameters are copied to a fixed-size local vector so that they can
+// stay in registers during the loop
+template <typename Impl, Index nArg, Index nPar>
+void StaticModel<Impl, nArg, nPar>::operator()(double *res, const double *arg,
+                                               const double *par,
+                                               const Index nPoint) const
+{
+    const ParVec p = Eigen::Map<const ParVec>(par);
+    ArgVec       x;
+
+    for (Index k = 0; k < nPoint; ++k)
+    {
+        for (Index i = 0; i < nArg; ++i)
+        {
+            x(i) = arg[i*nPoint + k];
+        }
+        res[k] = impl().value(x.data(), p.data());
+    }
+}
+
+template <typename Impl, Index nArg, Index nPar>
+inline void StaticModel<Impl, nArg, nPar>::parGradient(double *grad,
+                                                       const double *arg,
+                                                       const double *par)
+const
+{
+    impl().gradient(grad, arg, par);
+}
+
+template <typename Impl, Index nArg, Index nPar>
+typename StaticModel<Impl, nArg, nPar>::ParVec
+StaticModel<Impl, nArg, nPar>::parGradient(const ArgVec &arg,
+                                           const ParVec &par) const
+{
+    ParVec g;
+
+    impl().gradient(g.data(), arg.data(), par.data());
+
+    return g;
+}
+
+// DoubleModel factory /////////////////////////////////////////////////////////
+template <typename Impl, Index nArg, Index nPar>
+DoubleModel StaticModel<Impl, nArg, nPar>::makeModel(const bool makeHardCopy)
+const
+{
+    DoubleModel res;
+
+    if (makeHardCopy)
+    {
+        Impl copy(impl());
+
+        res.setFunction([copy](const double *x, const double *p)
+                        {return copy.value(x, p);}, nArg, nPar);
+        res.setBatchFunction([copy](double *r, const double *x,
+                                    const double *p, const Index nPoint)
+                             {copy(r, x, p, nPoint);});
+        res.setParGradientFunction([copy](double *g, const double *x,
+                                          const double *p)
+                                   {copy.gradient(g, x, p);});
+    }
+    else
+    {
+        const Impl *ptr = &impl();
+
+        res.setFunction([ptr](const double *x, const double *p)
+                        {return ptr->value(x, p);}, nArg, nPar);
+        res.setBatchFunction([ptr](double *r, const double *x,
+                                   const double *p, const Index nPoint)
+                             {(*ptr)(r, x, p, nPoint);});
+        res.setParGradientFunction([ptr](double *g, const double *x,
+                                         const double *p)
+                                   {ptr->gradient(g, x, p);});
+    }
+    impl().setNames(res);
+
+    return res;
+}
+
+template <typename Impl, Index nArg, Index nPar>
+StaticModel<Impl, nArg, nPar>::operator DoubleModel(void) const
+{
+    return makeModel();
+}
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_StaticModel_hpp_
@@ -29,87 +29,201 @@ using namespace Latan;
 // constructors ////////////////////////////////////////////////////////////////
 TabFunction::TabFunction(const DVec &x, const DVec &y,
                          const InterpType interpType)
+: interpType_(interpType)
 {
     setData(x, y);
-    setInterpolationType(interpType);
 }
 
 // access //////////////////////////////////////////////////////////////////////
+// the new points are merged with the current table, a point with an existing
+// x overwrites the previous value
 void TabFunction::setData(const DVec &x, const DVec &y)
 {
     if (x.size() != y.size())
     {
         LATAN_ERROR(Size, "tabulated function x/y data size mismatch");
     }
+
+    map<double, double> value;
+
+    for (unsigned int i = 0; i < x_.size(); ++i)
+    {
+        value[x_[i]] = y_[i];
+    }
     FOR_VEC(x, i)
     {
-        value_[x(i)] = y(i);
+        value[x(i)] = y(i);
     }
+    x_.clear();
+    y_.clear();
+    for (auto &p: value)
+    {
+        x_.push_back(p.first);
+        y_.push_back(p.second);
+    }
+    update();
 }
 
 void TabFunction::setInterpolationType(const InterpType interpType)
 {
     interpType_ = interpType;
+    update();
 }
 
-// function call ///////////////////////////////////////////////////////////////
-double TabFunction::operator()(const double *arg) const
+void TabFunction::update(void)
 {
-    double result = 0.0, x = arg[0];
+    const Index n = static_cast<Index>(x_.size());
+
+    isUniform_ = false;
+    y2_.clear();
+    if (n < 2)
+    {
+        return;
+    }
+
+    // uniform grid, the lookup corrects the rounding of the index so the
+    // tolerance only has to be small compared to the step
+    double step = (x_[n - 1] - x_[0])/(n - 1);
+
+    isUniform_ = true;
+    for (Index i = 1; (i < n) and isUniform_; ++i)
+    {
+        isUniform_ = (fabs(x_[i] - x_[0] - i*step) <= 1.0e-10*step);
+    }
+    invStep_ = 1./step;
+
+    // natural cubic spline second derivatives, tridiagonal system solved by
+    // Gaussian elimination
+    if (interpType_ == InterpType::CUBIC)
+    {
+        vector<double> u(n, 0.);
 
+        y2_.assign(n, 0.);
+        for (Index i = 1; i < n - 1; ++i)
+        {
+            double sig = (x_[i] - x_[i - 1])/(x_[i + 1] - x_[i - 1]);
+            double p   = sig*y2_[i - 1] + 2.;
 
-    if ((x < value_.begin()->first) or (x >= value_.rbegin()->first)) {
+            y2_[i] = (sig - 1.)/p;
+            u[i]   = (y_[i + 1] - y_[i])/(x_[i + 1] - x_[i])
+                     - (y_[i] - y_[i - 1])/(x_[i] - x_[i - 1]);
+            u[i]   = (6.*u[i]/(x_[i + 1] - x_[i - 1]) - sig*u[i - 1])/p;
+        }
+        for (Index i = n - 2; i >= 0; --i)
+        {
+            y2_[i] = y2_[i]*y2_[i + 1] + u[i];
+        }
+    }
+}
+
+// interval lookup /////////////////////////////////////////////////////////////
+Index TabFunction::interval(const double x) const
+{
+    const Index n = static_cast<Index>(x_.size());
+
+    if (n == 0)
+    {
+        LATAN_ERROR(Size, "tabulated function has no data");
+    }
+    if ((n < 2) or ((interpType_ == InterpType::QUADRATIC) and (n < 3)))
+    {
+        LATAN_ERROR(Size, "not enough points in tabulated function ("
+                    + strFrom(n) + ")");
+    }
+    if (std::isnan(x) or (x < x_.front()) or (x >= x_.back()))
+    {
         LATAN_ERROR(Range, "tabulated function variable out of range "
-                               "(x= " + strFrom(x) + " not in ["
-                           + strFrom(value_.begin()->first) + ", "
-                           + strFrom(value_.rbegin()->first) + "])");
+                    "(x= " + strFrom(x) + " not in ["
+                    + strFrom(x_.front()) + ", " + strFrom(x_.back()) + "])");
     }
 
-    auto i = value_.equal_range(x);
-    auto low = (x == i.first->first) ? i.first : prev(i.first);
-    auto high = i.second;
+    const Index last = n - 2;
+    Index       i;
 
-    switch (interpType_) {
-        case InterpType::LINEAR: {
+    if (isUniform_)
+    {
+        i = min(static_cast<Index>((x - x_[0])*invStep_), last);
+        while ((i > 0) and (x < x_[i]))
+        {
+            i--;
+        }
+        while ((i < last) and (x >= x_[i + 1]))
+        {
+            i++;
+        }
+    }
+    else
+    {
+        // binary search without data-dependent branches
+        const double *base = x_.data();
+        Index        len   = last + 1;
+
+        while (len > 1)
+        {
+            const Index half = len/2;
+
+            base += (base[half] <= x) ? half : 0;
+            len  -= half;
+        }
+        i = base - x_.data();
+    }
+
+    return i;
+}
+
+// function call ///////////////////////////////////////////////////////////////
+double TabFunction::eval(const double x, const Index i) const
+{
+    double result = 0.0;
+
+    switch (interpType_)
+    {
+        case InterpType::LINEAR:
+        {
             double x_a, x_b, y_a, y_b;
 
-            x_a = low->first;
-            x_b = high->first;
-            y_a = low->second;
-            y_b = high->second;
+            x_a    = x_[i];
+            x_b    = x_[i + 1];
+            y_a    = y_[i];
+            y_b    = y_[i + 1];
             result = y_a + (x - x_a) * (y_b - y_a) / (x_b - x_a);
             break;
         }
-        case InterpType::NEAREST: {
-            result = nearest(x)->second;
+        case InterpType::NEAREST:
+        {
+            result = (fabs(x_[i + 1] - x) < fabs(x_[i] - x)) ? y_[i + 1]
+                                                              : y_[i];
             break;
         }
-        case InterpType::QUADRATIC: {
-            double xs[3], ys[3], ds[3], d01, d02, d12;
-            auto it = nearest(x);
-            if (it == value_.begin()) {
-                it = next(it);
-            }
-            else if (it == prev(value_.end())) {
-                it = prev(it);
-            }
-            xs[0] = prev(it)->first;
-            ys[0] = prev(it)->second;
-            xs[1] = it->first;
-            ys[1] = it->second;
-            xs[2] = next(it)->first;
-            ys[2] = next(it)->second;
-            ds[0] = x - xs[0];
-            ds[1] = x - xs[1];
-            ds[2] = x - xs[2];
-            d01   = xs[0] - xs[1];
-            d02   = xs[0] - xs[2];
-            d12   = xs[1] - xs[2];
+        case InterpType::QUADRATIC:
+        {
+            const Index last = static_cast<Index>(x_.size()) - 1;
+            double      ds[3], d01, d02, d12;
+            Index       c;
+
+            // centre on the nearest point, away from the boundaries
+            c = (fabs(x_[i + 1] - x) < fabs(x_[i] - x)) ? i + 1 : i;
+            c = min(max(c, static_cast<Index>(1)), last - 1);
+            ds[0] = x - x_[c - 1];
+            ds[1] = x - x_[c];
+            ds[2] = x - x_[c + 1];
+            d01   = x_[c - 1] - x_[c];
+            d02   = x_[c - 1] - x_[c + 1];
+            d12   = x_[c] - x_[c + 1];
 
             // Lagrange polynomial coefficient computation
-            result = ds[1]/d01*ds[2]/d02*ys[0]
-                     -ds[0]/d01*ds[2]/d12*ys[1]
-                     +ds[0]/d02*ds[1]/d12*ys[2];
+            result = ds[1]/d01*ds[2]/d02*y_[c - 1]
+                     -ds[0]/d01*ds[2]/d12*y_[c]
+                     +ds[0]/d02*ds[1]/d12*y_[c + 1];
+            break;
+        }
+        case InterpType::CUBIC:
+        {
+            double h = x_[i + 1] - x_[i];
+            double a = (x_[i + 1] - x)/h, b = (x - x_[i])/h;
+
+            result = a*y_[i] + b*y_[i + 1]
+                     + ((a*a*a - a)*y2_[i] + (b*b*b - b)*y2_[i + 1])*h*h/6.;
             break;
         }
         default:
@@ -122,6 +236,27 @@ double TabFunction::operator()(const double *arg) const
     return result;
 }
 
+double TabFunction::operator()(const double *arg) const
+{
+    return eval(arg[0], interval(arg[0]));
+}
+
+// the interval of the previous point is tried first
+void TabFunction::operator()(double *res, const double *x,
+                             const Index nPoint) const
+{
+    Index i = -1;
+
+    for (Index k = 0; k < nPoint; ++k)
+    {
+        if ((i < 0) or !((x[k] >= x_[i]) and (x[k] < x_[i + 1])))
+        {
+            i = interval(x[k]);
+        }
+        res[k] = eval(x[k], i);
+    }
+}
+
 // DoubleFunction factory //////////////////////////////////////////////////////
 DoubleFunction TabFunction::makeFunction(const bool makeHardCopy) const
 {
@@ -129,13 +264,19 @@ DoubleFunction TabFunction::makeFunction(const bool makeHardCopy) const
 
     if (makeHardCopy)
     {
-        TabFunction copy(*this);
+        auto copy = make_shared<TabFunction>(*this);
 
-        res.setFunction([copy](const double *x){return copy(x);}, 1);
+        res.setFunction([copy](const double *x){return (*copy)(x);}, 1);
+        res.setBatchFunction([copy](double *r, const double *x,
+                                    const Index nPoint)
+                             {(*copy)(r, x, nPoint);});
     }
     else
     {
         res.setFunction([this](const double *x){return (*this)(x);}, 1);
+        res.setBatchFunction([this](double *r, const double *x,
+                                    const Index nPoint)
+                             {(*this)(r, x, nPoint);});
     }
 
     return res;
@@ -146,19 +287,3 @@ DoubleFunction Latan::interpolate(const DVec &x, const DVec &y,
 {
     return TabFunction(x, y, interpType).makeFunction();
 }
-
-map<double, double>::const_iterator TabFunction::nearest(const double x) const
-{
-    map<double, double>::const_iterator ret;
-    auto i = value_.equal_range(x);
-    auto low = (x == i.first->first) ? i.first : prev(i.first);
-    auto high = i.second;
-    if (fabs(high->first - x) < fabs(low->first - x)) {
-        ret = high;
-    }
-    else {
-        ret = low;
-    }
-
-    return ret;
-}
@@ -30,12 +30,17 @@ BEGIN_LATAN_NAMESPACE
 /******************************************************************************
  *                      tabulated function: 1D only                           *
  ******************************************************************************/
-
+// the table is stored in sorted contiguous arrays, the interval containing a
+// point is found in constant time for uniformly spaced nodes and by binary
+// search otherwise; CUBIC is a natural cubic spline, its coefficients are
+// computed when the data or the interpolation type is set; a table with too
+// few points (less than two, or three for QUADRATIC) throws when evaluated
 enum class InterpType
 {
   NEAREST,
   LINEAR,
-  QUADRATIC
+  QUADRATIC,
+  CUBIC
 };
 
 class TabFunction: public DoubleFunctionFactory
@@ -52,13 +57,22 @@ public:
     void setInterpolationType(const InterpType interpType);
     // function call
     double operator()(const double *arg) const;
+    // batched call, res[k] = f(x[k]), faster if the x[k] are sorted
+    void   operator()(double *res, const double *x, const Index nPoint) const;
     // factory
     virtual DoubleFunction makeFunction(const bool makeHardCopy = true) const;
 private:
-    std::map<double, double>::const_iterator nearest(const double x) const;
-
-    std::map<double, double> value_;
-    InterpType interpType_;
+    // update uniform grid and spline data
+    void   update(void);
+    // index i such that x_[i] <= x < x_[i + 1]
+    Index  interval(const double x) const;
+    // interpolation on the interval i
+    double eval(const double x, const Index i) const;
+private:
+    std::vector<double> x_, y_, y2_;
+    bool                isUniform_{false};
+    double              invStep_{0.};
+    InterpType          interpType_{InterpType::LINEAR};
 };
 
 DoubleFunction interpolate(const DVec &x, const DVec &y,
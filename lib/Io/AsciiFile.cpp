@@ -53,6 +53,19 @@ AsciiFile::~AsciiFile(void)
 }
 
 // access //////////////////////////////////////////////////////////////////////
+// the resampling scheme follows the number of samples, nothing is written for
+// the bootstrap so that these files are readable by previous versions
+static string resamplingTag(const Resampling resampling)
+{
+    switch (resampling)
+    {
+        case Resampling::jackknife:
+            return " jackknife";
+        default:
+            return "";
+    }
+}
+
 void AsciiFile::save(const DMat &m, const std::string &name)
 {
     if (name.empty())
@@ -81,7 +94,7 @@ void AsciiFile::save(const DSample &ds, const std::string &name)
     checkWritability();
     isParsed_ = false;
     fileStream_ << "#L latan_begin rs_sample " << name << endl;
-    fileStream_ << ds.size() << endl;
+    fileStream_ << ds.size() << resamplingTag(ds.getResampling()) << endl;
     save(ds.matrix(), name + "_data");
     fileStream_ << "#L latan_end rs_sample " << endl;
 }
@@ -96,7 +109,7 @@ void AsciiFile::save(const DMatSample &ms, const std::string &name)
     checkWritability();
     isParsed_ = false;
     fileStream_ << "#L latan_begin rs_sample " << name << endl;
-    fileStream_ << ms.size() << endl;
+    fileStream_ << ms.size() << resamplingTag(ms.getResampling()) << endl;
     save(ms[central], name + "_C");
     for (Index i = 0; i < ms.size(); ++i)
     {
@@ -94,6 +94,7 @@ void Hdf5File::save(const DSample &ds, const string &name)
     attr.write(PredType::NATIVE_SHORT, &dSampleType);
     attr  = group.createAttribute("nSample", PredType::NATIVE_LONG, attrSpace);
     attr.write(PredType::NATIVE_LONG, &nSample);
+    saveResampling(group, ds.getResampling());
     dataset = group.createDataSet("data", PredType::NATIVE_DOUBLE, dataSpace);
     dataset.write(ds.data(), PredType::NATIVE_DOUBLE);
 }
@@ -120,6 +121,7 @@ void Hdf5File::save(const DMatSample &ms, const string &name)
     attr.write(PredType::NATIVE_SHORT, &dMatSampleType);
     attr  = group.createAttribute("nSample", PredType::NATIVE_LONG, attrSpace);
     attr.write(PredType::NATIVE_LONG, &nSample);
+    saveResampling(group, ms.getResampling());
     FOR_STAT_ARRAY(ms, s)
     {
         datasetName = (s == central) ? "data_C" : ("data_S_" + strFrom(s));
@@ -130,6 +132,104 @@ void Hdf5File::save(const DMatSample &ms, const string &name)
     }
 }
 
+void Hdf5File::save(const DPackedMatSample &ms, const string &name)
+{
+    if (name.empty())
+    {
+        LATAN_ERROR(Io, "trying to save data with an empty name");
+    }
+
+    Group          group;
+    Attribute      attr;
+    DataSet        dataset;
+    hsize_t        dim[2]  = {static_cast<hsize_t>(ms.getNRow()),
+                              static_cast<hsize_t>(ms.getNCol())};
+    hsize_t        attrDim = 1;
+    DataSpace      dataSpace(2, dim), attrSpace(1, &attrDim);
+    const long int nSample = ms.size();
+    string         datasetName;
+
+    group = h5File_->createGroup(name.c_str() + nameOffset(name));
+    attr  = group.createAttribute("type", PredType::NATIVE_SHORT, attrSpace);
+    attr.write(PredType::NATIVE_SHORT, &dMatSampleType);
+    attr  = group.createAttribute("nSample", PredType::NATIVE_LONG, attrSpace);
+    attr.write(PredType::NATIVE_LONG, &nSample);
+    saveResampling(group, ms.getResampling());
+    FOR_STAT_ARRAY(ms, s)
+    {
+        datasetName = (s == central) ? "data_C" : ("data_S_" + strFrom(s));
+        dataset     = group.createDataSet(datasetName.c_str(),
+                                          PredType::NATIVE_DOUBLE,
+                                          dataSpace);
+        dataset.write(ms[s].data(), PredType::NATIVE_DOUBLE);
+    }
+}
+
+void Hdf5File::readPacked(DPackedMatSample &ms, const string &name)
+{
+    if (!((mode_ & Mode::read) and (isOpen())))
+    {
+        LATAN_ERROR(Io, "file '" + name_ + "' is not opened in read mode");
+    }
+
+    string           groupName;
+    Group            group;
+    Attribute        attribute;
+    DataSet          dataset;
+    DataSpace        dataspace;
+    IoObject::IoType type;
+    long int         nSample;
+    hsize_t          dim[2];
+
+    groupName = (name.empty()) ? getFirstGroupName() : name;
+    if (groupName.empty())
+    {
+        LATAN_ERROR(Io, "file '" + name_ + "' is empty");
+    }
+    group     = h5File_->openGroup(groupName.c_str());
+    attribute = group.openAttribute("type");
+    attribute.read(PredType::NATIVE_SHORT, &type);
+    if (type != IoObject::IoType::dMatSample)
+    {
+        LATAN_ERROR(Io, "'" + groupName + "' is not a matrix sample ("
+                    + name_ + ")");
+    }
+    attribute = group.openAttribute("nSample");
+    attribute.read(PredType::NATIVE_LONG, &nSample);
+    dataset   = group.openDataSet("data_C");
+    dataspace = dataset.getSpace();
+    if (dataspace.getSimpleExtentNdims() != 2)
+    {
+        LATAN_ERROR(Io, "'" + groupName + "/data_C' is not a matrix ("
+                    + name_ + ")");
+    }
+    dataspace.getSimpleExtentDims(dim);
+    ms.resize(nSample, dim[0], dim[1]);
+    ms.setResampling(loadResampling(group));
+    FOR_STAT_ARRAY(ms, s)
+    {
+        if (s != central)
+        {
+            string  dsName = "data_S_" + strFrom(s);
+            hsize_t sDim[2] = {0, 0};
+
+            dataset   = group.openDataSet(dsName.c_str());
+            dataspace = dataset.getSpace();
+            if (dataspace.getSimpleExtentNdims() == 2)
+            {
+                dataspace.getSimpleExtentDims(sDim);
+            }
+            if ((sDim[0] != dim[0]) or (sDim[1] != dim[1]))
+            {
+                LATAN_ERROR(Io, "'" + groupName + "/" + dsName
+                            + "' does not have the size of '" + groupName
+                            + "/data_C' (" + name_ + ")");
+            }
+        }
+        dataset.read(ms[s].data(), PredType::NATIVE_DOUBLE);
+    }
+}
+
 // read first name ////////////////////////////////////////////////////////////
 string Hdf5File::getFirstName(void)
 {
@@ -142,6 +242,36 @@ bool Hdf5File::isOpen(void) const
     return (h5File_ != nullptr);
 }
 
+// resampling scheme attribute ////////////////////////////////////////////////
+void Hdf5File::saveResampling(Group &group, const Resampling resampling)
+{
+    if (resampling != Resampling::bootstrap)
+    {
+        Attribute   attr;
+        hsize_t     attrDim = 1;
+        DataSpace   attrSpace(1, &attrDim);
+        const short r = static_cast<short>(resampling);
+
+        attr = group.createAttribute("resampling", PredType::NATIVE_SHORT,
+                                     attrSpace);
+        attr.write(PredType::NATIVE_SHORT, &r);
+    }
+}
+
+Resampling Hdf5File::loadResampling(Group &group)
+{
+    short r = static_cast<short>(Resampling::bootstrap);
+
+    if (H5Aexists(group.getId(), "resampling") > 0)
+    {
+        Attribute attr = group.openAttribute("resampling");
+
+        attr.read(PredType::NATIVE_SHORT, &r);
+    }
+
+    return static_cast<Resampling>(r);
+}
+
 // check names for forbidden characters ////////////////////////////////////////
 size_t Hdf5File::nameOffset(const string &name)
 {
@@ -302,6 +432,7 @@ string Hdf5File::load(const string &name)
                 data_[groupName].reset(pt);
                 dataset = group.openDataSet("data");
                 load(*pt, dataset);
+                pt->setResampling(loadResampling(group));
                 break;
             }
             case IoObject::IoType::dMatSample:
@@ -313,6 +444,7 @@ string Hdf5File::load(const string &name)
                 attribute = group.openAttribute("nSample");
                 attribute.read(PredType::NATIVE_LONG, &nSample);
                 pt->resize(nSample);
+                pt->setResampling(loadResampling(group));
                 FOR_STAT_ARRAY(*pt, s)
                 {
                     if (s == central)
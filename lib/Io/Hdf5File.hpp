@@ -24,6 +24,7 @@
 #include <LatAnalyze/Io/File.hpp>
 #include <LatAnalyze/Core/Mat.hpp>
 #include <LatAnalyze/Statistics/MatSample.hpp>
+#include <LatAnalyze/Statistics/PackedMatSample.hpp>
 #include <H5Cpp.h>
 
 BEGIN_LATAN_NAMESPACE
@@ -47,6 +48,10 @@ public:
     virtual void save(const DMat &m, const std::string &name);
     virtual void save(const DSample &ds, const std::string &name);
     virtual void save(const DMatSample &ms, const std::string &name);
+    // packed matrix samples, same format as DMatSample, the samples are
+    // written from and read to the sample buffer without copies
+            void save(const DPackedMatSample &ms, const std::string &name);
+            void readPacked(DPackedMatSample &ms, const std::string &name = "");
     // read first name
     virtual std::string getFirstName(void);
     // tests
@@ -61,6 +66,10 @@ private:
                    void load(DMat &m, const H5NS::DataSet &d);
                    void load(DSample &ds, const H5NS::DataSet &d);
                    void load(DMatSample &s, const H5NS::DataSet &d);
+    // resampling scheme attribute, only written for non-bootstrap samples
+    static void       saveResampling(H5NS::Group &group,
+                                     const Resampling resampling);
+    static Resampling loadResampling(H5NS::Group &group);
     // check name for forbidden characters
     static size_t nameOffset(const std::string &name);
 private:
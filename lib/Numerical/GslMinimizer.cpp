@@ -303,27 +303,38 @@ void GslMinimizer::dfWrapper(const gsl_vector *x, void *vdata, gsl_vector * df)
     GslFuncData        &data = *static_cast<GslFuncData *>(vdata);
     const unsigned int n     = data.f->getNArg();
     
-    for (unsigned int i = 0; i < n; ++i)
+    // analytic gradient if the function has one, finite differences
+    // otherwise
+    if (data.f->hasGradientFunction())
     {
-        data.d->setDir(i);
-        gsl_vector_set(df, i, (*(data.d))(x->data));
+        DVec grad(n);
+
+        data.f->gradient(grad.data(), x->data);
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            gsl_vector_set(df, i, grad(i));
+        }
+        data.evalCount++;
+    }
+    else
+    {
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            data.d->setDir(i);
+            gsl_vector_set(df, i, (*(data.d))(x->data));
+        }
+        data.evalCount += data.d->getNPoint()*n;
     }
-    data.evalCount += data.d->getNPoint()*n;
 }
 
 void GslMinimizer::fdfWrapper(const gsl_vector *x, void *vdata, double *f,
                               gsl_vector * df)
 {
-    GslFuncData        &data = *static_cast<GslFuncData *>(vdata);
-    const unsigned int n     = data.f->getNArg();
+    GslFuncData &data = *static_cast<GslFuncData *>(vdata);
     
-    for (unsigned int i = 0; i < n; ++i)
-    {
-        data.d->setDir(i);
-        gsl_vector_set(df, i, (*(data.d))(x->data));
-    }
+    dfWrapper(x, vdata, df);
     *f = (*data.f)(x->data);
-    data.evalCount += data.d->getNPoint()*n + 1;
+    data.evalCount++;
 }
 
 // algorithm names /////////////////////////////////////////////////////////////
@@ -21,12 +21,56 @@
 #include <LatAnalyze/includes.hpp>
 #include <Minuit2/Minuit2Minimizer.h>
 #include <Math/Functor.h>
+#include <Math/IFunction.h>
 
 using namespace std;
 using namespace Latan;
 
 static constexpr double initErr = 0.1;
 
+/******************************************************************************
+ *              Minuit interface to functions with a gradient                 *
+ ******************************************************************************/
+// Minuit uses the gradient of the function instead of finite differences
+class MinuitGradFunction: public ROOT::Math::IMultiGradFunction
+{
+public:
+    // constructor
+    explicit MinuitGradFunction(const DoubleFunction &f)
+    : f_(f)
+    {}
+    // destructor
+    virtual ~MinuitGradFunction(void) = default;
+    // Minuit interface
+    virtual unsigned int NDim(void) const
+    {
+        return static_cast<unsigned int>(f_.getNArg());
+    }
+    virtual ROOT::Math::IMultiGenFunction * Clone(void) const
+    {
+        return new MinuitGradFunction(f_);
+    }
+    virtual void Gradient(const double *x, double *grad) const
+    {
+        f_.gradient(grad, x);
+    }
+private:
+    virtual double DoEval(const double *x) const
+    {
+        return f_(x);
+    }
+    virtual double DoDerivative(const double *x, unsigned int i) const
+    {
+        DVec grad(f_.getNArg());
+
+        f_.gradient(grad.data(), x);
+
+        return grad(i);
+    }
+private:
+    const DoubleFunction &f_;
+};
+
 /******************************************************************************
  *                    MinuitMinimizer implementation                          *
  ******************************************************************************/
@@ -109,11 +153,19 @@ const DVec & MinuitMinimizer::operator()(const DoubleFunction &f)
     min.SetPrintLevel(printLevel);
     
     // set function and variables
-    Math::Functor minuitF(f, x.size());
-    string        name;
-    double        val, step;
+    Math::Functor      minuitF(f, x.size());
+    MinuitGradFunction minuitGradF(f);
+    string             name;
+    double             val, step;
     
-    min.SetFunction(minuitF);
+    if (f.hasGradientFunction())
+    {
+        min.SetFunction(minuitGradF);
+    }
+    else
+    {
+        min.SetFunction(minuitF);
+    }
     for (Index i = 0; i < x.size(); ++i)
     {
         name = f.varName().getName(i);
@@ -170,7 +170,14 @@ double NloptMinimizer::funcWrapper(unsigned int n, const double *arg,
 {
     NloptFuncData &data = *static_cast<NloptFuncData *>(vdata);
     
-    if (grad)
+    // analytic gradient if the function has one, finite differences
+    // otherwise
+    if (grad and data.f->hasGradientFunction())
+    {
+        data.f->gradient(grad, arg);
+        data.evalCount++;
+    }
+    else if (grad)
     {
         for (unsigned int i = 0; i < n; ++i)
         {
@@ -28,6 +28,20 @@ using namespace Latan;
  ******************************************************************************/
 DoubleModel CorrelatorModels::makeExpModel(const Index nState)
 {
+    switch (nState)
+    {
+    case 1:
+        return ExpModel<1>().makeModel();
+    case 2:
+        return ExpModel<2>().makeModel();
+    case 3:
+        return ExpModel<3>().makeModel();
+    case 4:
+        return ExpModel<4>().makeModel();
+    default:
+        break;
+    }
+
     DoubleModel mod;
 
     mod.setFunction([nState](const double *x, const double *p)
@@ -41,17 +55,50 @@ DoubleModel CorrelatorModels::makeExpModel(const Index nState)
 
         return res;
     }, 1, 2*nState);
-    for (unsigned int i = 0; i < nState; ++i)
+    mod.setBatchFunction([nState](double *res, const double *x,
+                                  const double *p, const Index nPoint)
     {
-        mod.parName().setName(2*i, "E_" + strFrom(i));
-        mod.parName().setName(2*i + 1, "Z_" + strFrom(i));
-    }
+        fill(res, res + nPoint, 0.);
+        for (unsigned int i = 0; i < nState; ++i)
+        {
+            for (Index k = 0; k < nPoint; ++k)
+            {
+                res[k] += p[2*i + 1]*exp(-p[2*i]*x[k]);
+            }
+        }
+    });
+    mod.setParGradientFunction([nState](double *g, const double *x,
+                                        const double *p)
+    {
+        for (unsigned int i = 0; i < nState; ++i)
+        {
+            const double e = exp(-p[2*i]*x[0]);
+
+            g[2*i]     = -x[0]*p[2*i + 1]*e;
+            g[2*i + 1] = e;
+        }
+    });
+    setStateNames(mod, nState);
 
     return mod;
 }
 
 DoubleModel CorrelatorModels::makeCoshModel(const Index nState, const Index nt)
 {
+    switch (nState)
+    {
+    case 1:
+        return CoshModel<1>(nt).makeModel();
+    case 2:
+        return CoshModel<2>(nt).makeModel();
+    case 3:
+        return CoshModel<3>(nt).makeModel();
+    case 4:
+        return CoshModel<4>(nt).makeModel();
+    default:
+        break;
+    }
+
     DoubleModel mod;
 
     mod.setFunction([nState, nt](const double *x, const double *p)
@@ -65,17 +112,52 @@ DoubleModel CorrelatorModels::makeCoshModel(const Index nState, const Index nt)
 
         return res;
     }, 1, 2*nState);
-    for (unsigned int i = 0; i < nState; ++i)
+    mod.setBatchFunction([nState, nt](double *res, const double *x,
+                                      const double *p, const Index nPoint)
     {
-        mod.parName().setName(2*i, "E_" + strFrom(i));
-        mod.parName().setName(2*i + 1, "Z_" + strFrom(i));
-    }
+        fill(res, res + nPoint, 0.);
+        for (unsigned int i = 0; i < nState; ++i)
+        {
+            for (Index k = 0; k < nPoint; ++k)
+            {
+                res[k] += p[2*i + 1]*(exp(-p[2*i]*x[k])
+                                      + exp(-p[2*i]*(nt - x[k])));
+            }
+        }
+    });
+    mod.setParGradientFunction([nState, nt](double *g, const double *x,
+                                            const double *p)
+    {
+        for (unsigned int i = 0; i < nState; ++i)
+        {
+            const double ef = exp(-p[2*i]*x[0]);
+            const double eb = exp(-p[2*i]*(nt - x[0]));
+
+            g[2*i]     = -p[2*i + 1]*(x[0]*ef + (nt - x[0])*eb);
+            g[2*i + 1] = ef + eb;
+        }
+    });
+    setStateNames(mod, nState);
 
     return mod;
 }
 
 DoubleModel CorrelatorModels::makeSinhModel(const Index nState, const Index nt)
 {
+    switch (nState)
+    {
+    case 1:
+        return SinhModel<1>(nt).makeModel();
+    case 2:
+        return SinhModel<2>(nt).makeModel();
+    case 3:
+        return SinhModel<3>(nt).makeModel();
+    case 4:
+        return SinhModel<4>(nt).makeModel();
+    default:
+        break;
+    }
+
     DoubleModel mod;
 
     mod.setFunction([nState, nt](const double *x, const double *p)
@@ -89,11 +171,32 @@ DoubleModel CorrelatorModels::makeSinhModel(const Index nState, const Index nt)
 
         return res;
     }, 1, 2*nState);
-    for (unsigned int i = 0; i < nState; ++i)
+    mod.setBatchFunction([nState, nt](double *res, const double *x,
+                                      const double *p, const Index nPoint)
     {
-        mod.parName().setName(2*i, "E_" + strFrom(i));
-        mod.parName().setName(2*i + 1, "Z_" + strFrom(i));
-    }
+        fill(res, res + nPoint, 0.);
+        for (unsigned int i = 0; i < nState; ++i)
+        {
+            for (Index k = 0; k < nPoint; ++k)
+            {
+                res[k] += p[2*i + 1]*(exp(-p[2*i]*x[k])
+                                      - exp(-p[2*i]*(nt - x[k])));
+            }
+        }
+    });
+    mod.setParGradientFunction([nState, nt](double *g, const double *x,
+                                            const double *p)
+    {
+        for (unsigned int i = 0; i < nState; ++i)
+        {
+            const double ef = exp(-p[2*i]*x[0]);
+            const double eb = exp(-p[2*i]*(nt - x[0]));
+
+            g[2*i]     = -p[2*i + 1]*(x[0]*ef - (nt - x[0])*eb);
+            g[2*i + 1] = ef - eb;
+        }
+    });
+    setStateNames(mod, nState);
 
     return mod;
 }
@@ -106,6 +209,16 @@ DoubleModel CorrelatorModels::makeConstModel(void)
     {
         return p[0];
     }, 1, 1);
+    mod.setBatchFunction([](double *res, const double *x __dumb,
+                            const double *p, const Index nPoint)
+    {
+        fill(res, res + nPoint, p[0]);
+    });
+    mod.setParGradientFunction([](double *g, const double *x __dumb,
+                                  const double *p __dumb)
+    {
+        g[0] = 1.;
+    });
     mod.parName().setName(0, "cst");
 
     return mod;
@@ -119,6 +232,20 @@ DoubleModel CorrelatorModels::makeLinearModel(void)
     {
         return p[1] + p[0]*x[0];
     }, 1, 2);
+    mod.setBatchFunction([](double *res, const double *x, const double *p,
+                            const Index nPoint)
+    {
+        for (Index k = 0; k < nPoint; ++k)
+        {
+            res[k] = p[1] + p[0]*x[k];
+        }
+    });
+    mod.setParGradientFunction([](double *g, const double *x,
+                                  const double *p __dumb)
+    {
+        g[0] = x[0];
+        g[1] = 1.;
+    });
 
     return mod;
 }
@@ -188,6 +315,15 @@ DoubleModel CorrelatorModels::makeModel(const CorrelatorModels::ModelPar par,
     }
 }
 
+void CorrelatorModels::setStateNames(DoubleModel &model, const Index nState)
+{
+    for (Index i = 0; i < nState; ++i)
+    {
+        model.parName().setName(2*i, "E_" + strFrom(i));
+        model.parName().setName(2*i + 1, "Z_" + strFrom(i));
+    }
+}
+
 DVec CorrelatorModels::parameterGuess(const DMatSample &corr, 
                                       const ModelPar par)
 {
@@ -22,6 +22,7 @@
 
 #include <LatAnalyze/Global.hpp>
 #include <LatAnalyze/Functional/Model.hpp>
+#include <LatAnalyze/Functional/StaticModel.hpp>
 #include <LatAnalyze/Numerical/FFT.hpp>
 #include <LatAnalyze/Statistics/XYSampleData.hpp>
 
@@ -48,8 +49,167 @@ namespace CorrelatorModels
     ModelPar    parseModel(const std::string s);
     DoubleModel makeModel(const ModelPar par, const Index nt);
     DVec        parameterGuess(const DMatSample &corr, const ModelPar par);
+    // names E_i and Z_i of the energies and amplitudes
+    void        setStateNames(DoubleModel &model, const Index nState);
+
+    // models with a number of states fixed at compile time, the make*Model
+    // functions above use them for 1 to 4 states
+    template <Index nState>
+    class ExpModel: public StaticModel<ExpModel<nState>, 1, 2*nState>
+    {
+    public:
+        double value(const double *x, const double *p) const;
+        void   gradient(double *g, const double *x, const double *p) const;
+        void   setNames(DoubleModel &model) const;
+    };
+
+    template <Index nState>
+    class CoshModel: public StaticModel<CoshModel<nState>, 1, 2*nState>
+    {
+    public:
+        explicit CoshModel(const Index nt);
+        double value(const double *x, const double *p) const;
+        void   gradient(double *g, const double *x, const double *p) const;
+        void   setNames(DoubleModel &model) const;
+    private:
+        Index nt_;
+    };
+
+    template <Index nState>
+    class SinhModel: public StaticModel<SinhModel<nState>, 1, 2*nState>
+    {
+    public:
+        explicit SinhModel(const Index nt);
+        double value(const double *x, const double *p) const;
+        void   gradient(double *g, const double *x, const double *p) const;
+        void   setNames(DoubleModel &model) const;
+    private:
+        Index nt_;
+    };
 };
 
+/******************************************************************************
+ *               Fixed-size correlator models implementation                  *
+ ******************************************************************************/
+// exponential /////////////////////////////////////////////////////////////////
+template <Index nState>
+inline double CorrelatorModels::ExpModel<nState>::value(const double *x,
+                                                        const double *p) const
+{
+    double res = 0.;
+
+    for (Index i = 0; i < nState; ++i)
+    {
+        res += p[2*i + 1]*exp(-p[2*i]*x[0]);
+    }
+
+    return res;
+}
+
+template <Index nState>
+inline void CorrelatorModels::ExpModel<nState>::gradient(double *g,
+                                                         const double *x,
+                                                         const double *p) const
+{
+    for (Index i = 0; i < nState; ++i)
+    {
+        const double e = exp(-p[2*i]*x[0]);
+
+        g[2*i]     = -x[0]*p[2*i + 1]*e;
+        g[2*i + 1] = e;
+    }
+}
+
+template <Index nState>
+void CorrelatorModels::ExpModel<nState>::setNames(DoubleModel &model) const
+{
+    setStateNames(model, nState);
+}
+
+// hyperbolic cosine ///////////////////////////////////////////////////////////
+template <Index nState>
+CorrelatorModels::CoshModel<nState>::CoshModel(const Index nt)
+: nt_(nt)
+{}
+
+template <Index nState>
+inline double CorrelatorModels::CoshModel<nState>::value(const double *x,
+                                                         const double *p) const
+{
+    double res = 0.;
+
+    for (Index i = 0; i < nState; ++i)
+    {
+        res += p[2*i + 1]*(exp(-p[2*i]*x[0]) + exp(-p[2*i]*(nt_ - x[0])));
+    }
+
+    return res;
+}
+
+template <Index nState>
+inline void CorrelatorModels::CoshModel<nState>::gradient(double *g,
+                                                          const double *x,
+                                                          const double *p)
+const
+{
+    for (Index i = 0; i < nState; ++i)
+    {
+        const double ef = exp(-p[2*i]*x[0]);
+        const double eb = exp(-p[2*i]*(nt_ - x[0]));
+
+        g[2*i]     = -p[2*i + 1]*(x[0]*ef + (nt_ - x[0])*eb);
+        g[2*i + 1] = ef + eb;
+    }
+}
+
+template <Index nState>
+void CorrelatorModels::CoshModel<nState>::setNames(DoubleModel &model) const
+{
+    setStateNames(model, nState);
+}
+
+// hyperbolic sine /////////////////////////////////////////////////////////////
+template <Index nState>
+CorrelatorModels::SinhModel<nState>::SinhModel(const Index nt)
+: nt_(nt)
+{}
+
+template <Index nState>
+inline double CorrelatorModels::SinhModel<nState>::value(const double *x,
+                                                         const double *p) const
+{
+    double res = 0.;
+
+    for (Index i = 0; i < nState; ++i)
+    {
+        res += p[2*i + 1]*(exp(-p[2*i]*x[0]) - exp(-p[2*i]*(nt_ - x[0])));
+    }
+
+    return res;
+}
+
+template <Index nState>
+inline void CorrelatorModels::SinhModel<nState>::gradient(double *g,
+                                                          const double *x,
+                                                          const double *p)
+const
+{
+    for (Index i = 0; i < nState; ++i)
+    {
+        const double ef = exp(-p[2*i]*x[0]);
+        const double eb = exp(-p[2*i]*(nt_ - x[0]));
+
+        g[2*i]     = -p[2*i + 1]*(x[0]*ef - (nt_ - x[0])*eb);
+        g[2*i + 1] = ef - eb;
+    }
+}
+
+template <Index nState>
+void CorrelatorModels::SinhModel<nState>::setNames(DoubleModel &model) const
+{
+    setStateNames(model, nState);
+}
+
 /******************************************************************************
  *                         Correlator utilities                               *
  ******************************************************************************/
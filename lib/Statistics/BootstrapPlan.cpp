@@ -0,0 +1,151 @@
+/*
+ * BootstrapPlan.cpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LatAnalyze/Statistics/BootstrapPlan.hpp>
+#include <LatAnalyze/includes.hpp>
+
+using namespace std;
+using namespace Latan;
+
+/******************************************************************************
+ *                       BootstrapPlan implementation                         *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+BootstrapPlan::BootstrapPlan(const Index nSample, const Index nConf,
+                             const SeedType seed, const Generator gen)
+: nSample_(nSample), nConf_(nConf)
+{
+    if (nConf_ < 1)
+    {
+        LATAN_ERROR(Size, "bootstrap plan with no configuration");
+    }
+    if (nSample_ < 0)
+    {
+        LATAN_ERROR(Size, "bootstrap plan with a negative number of samples");
+    }
+
+    weight_.setZero(nSample_ + 1, nConf_);
+    weight_.row(0).fill(1.);
+    switch (gen)
+    {
+        case Generator::mersenneTwister:
+        {
+            mt19937                         mt(seed);
+            uniform_int_distribution<Index> dis(0, nConf_ - 1);
+
+            for (Index i = 0; i < nSample_; ++i)
+            {
+                for (Index j = 0; j < nConf_; ++j)
+                {
+                    weight_(i + 1, dis(mt)) += 1.;
+                }
+            }
+            break;
+        }
+        case Generator::counter:
+            for (Index i = 0; i < nSample_; ++i)
+            {
+                for (Index j = 0; j < nConf_; ++j)
+                {
+                    const Index k = counterBootstrapIndex(seed, i, j, nConf_);
+
+                    weight_(i + 1, k) += 1.;
+                }
+            }
+            break;
+        default:
+            LATAN_ERROR(Argument, "unknown bootstrap generator");
+            break;
+    }
+    weight_ /= static_cast<double>(nConf_);
+}
+
+// access //////////////////////////////////////////////////////////////////////
+Index BootstrapPlan::getNSample(void) const
+{
+    return nSample_;
+}
+
+Index BootstrapPlan::getNConf(void) const
+{
+    return nConf_;
+}
+
+const DMat & BootstrapPlan::getWeight(void) const
+{
+    return weight_;
+}
+
+// resampling //////////////////////////////////////////////////////////////////
+DMatSample BootstrapPlan::operator()(const Dataset<DMat> &data,
+                                     const unsigned int nThread) const
+{
+    if (data.size() != nConf_)
+    {
+        LATAN_ERROR(Size, "dataset size (" + strFrom(data.size())
+                    + ") does not match the bootstrap plan ("
+                    + strFrom(nConf_) + " configurations)");
+    }
+
+    const Index    nRow = data[0].rows(), nCol = data[0].cols();
+    const Index    nElt = nRow*nCol, nRes = nSample_ + 1;
+    Index          nt;
+    DMat           conf(nElt, nConf_), res(nElt, nRes);
+    DMatSample     s(nSample_, nRow, nCol);
+    vector<thread> worker;
+
+    // one configuration per column, res(:, i) is the flattened sample i - 1
+    for (Index j = 0; j < nConf_; ++j)
+    {
+        if ((data[j].rows() != nRow) or (data[j].cols() != nCol))
+        {
+            LATAN_ERROR(Size, "configuration " + strFrom(j)
+                        + " has a different size from configuration 0");
+        }
+        conf.col(j) = Eigen::Map<const Eigen::VectorXd>(data[j].data(), nElt);
+    }
+
+    // each thread computes a contiguous block of samples
+    auto work = [this, &conf, &res](const Index start, const Index size)
+    {
+        res.middleCols(start, size).noalias() =
+            conf*weight_.middleRows(start, size).transpose();
+    };
+
+    nt = min(static_cast<Index>(nThread), nRes);
+    nt = max(nt, static_cast<Index>(1));
+    for (Index t = 1; t < nt; ++t)
+    {
+        const Index start = t*nRes/nt, end = (t + 1)*nRes/nt;
+
+        worker.emplace_back(work, start, end - start);
+    }
+    work(0, nRes/nt);
+    for (auto &w: worker)
+    {
+        w.join();
+    }
+    FOR_STAT_ARRAY(s, i)
+    {
+        s[i] = Eigen::Map<const Eigen::MatrixXd>(res.col(i + 1).data(),
+                                                 nRow, nCol);
+    }
+
+    return s;
+}
@@ -0,0 +1,68 @@
+/*
+ * BootstrapPlan.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_BootstrapPlan_hpp_
+#define Latan_BootstrapPlan_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Core/Mat.hpp>
+#include <LatAnalyze/Statistics/Dataset.hpp>
+#include <LatAnalyze/Statistics/MatSample.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                           BootstrapPlan class                              *
+ ******************************************************************************/
+// bootstrap of the mean as a (nSample + 1) x nConf weight matrix, the row 0
+// is the central value and the row i + 1 holds the counts of the sample i
+// divided by nConf; the draws are the ones of Dataset::bootstrapMean
+// (mersenneTwister) or Dataset::parallelBootstrapMean (counter) for the same
+// seed, so a single plan can resample all the names of a manifest
+class BootstrapPlan
+{
+public:
+    enum class Generator
+    {
+        mersenneTwister = 0,
+        counter         = 1
+    };
+public:
+    // constructors
+    BootstrapPlan(void) = default;
+    BootstrapPlan(const Index nSample, const Index nConf, const SeedType seed,
+                  const Generator gen = Generator::mersenneTwister);
+    // destructor
+    virtual ~BootstrapPlan(void) = default;
+    // access
+    Index        getNSample(void) const;
+    Index        getNConf(void) const;
+    const DMat & getWeight(void) const;
+    // resampling, one matrix product for all the samples, split over the
+    // samples between nThread threads
+    DMatSample operator()(const Dataset<DMat> &data,
+                          const unsigned int nThread = 1) const;
+private:
+    Index nSample_{0}, nConf_{0};
+    DMat  weight_;
+};
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_BootstrapPlan_hpp_
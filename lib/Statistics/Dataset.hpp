@@ -22,6 +22,8 @@
 
 #include <LatAnalyze/Global.hpp>
 #include <LatAnalyze/Io/File.hpp>
+#include <LatAnalyze/Statistics/Random.hpp>
+#include <LatAnalyze/Statistics/StatAccumulator.hpp>
 #include <LatAnalyze/Statistics/StatArray.hpp>
 
 BEGIN_LATAN_NAMESPACE
@@ -44,11 +46,31 @@ public:
     // IO
     template <typename FileType>
     void load(const std::string &listFileName, const std::string &dataName);
+    // one-pass statistics on the files of a manifest, only one configuration
+    // is in memory at a time
+    template <typename FileType>
+    static StatAccumulator<T> accumulate(const std::string &listFileName,
+                                         const std::string &dataName,
+                                         const bool trackCovariance = false);
     // resampling
     Sample<T> bootstrapMean(const Index nSample, const SeedType seed);
     Sample<T> bootstrapMean(const Index nSample);
     void      dumpBootstrapSeq(std::ostream &out, const Index nSample,
                                const SeedType seed);
+    // bootstrap with a counter-based generator, the draw j of the sample s
+    // is counterBootstrapIndex(seed, s, j, size()), the samples are computed
+    // by nThread threads and the result does not depend on nThread
+    Sample<T> parallelBootstrapMean(const Index nSample, const SeedType seed,
+                                    const unsigned int nThread = 1);
+    void      dumpParallelBootstrapSeq(std::ostream &out,
+                                       const Index nSample,
+                                       const SeedType seed);
+    // delete-d jackknife on consecutive blocks of blockSize configurations,
+    // the sample k is the mean without the block k; the jackknife variance
+    // assumes blocks of equal size, so the size()%blockSize last configurations
+    // are dropped (also from the central value); the samples are computed in
+    // O(size()) from the total sum
+    Sample<T> jackknifeMean(const Index blockSize = 1);
 private:
     // mean from pointer vector for resampling
     void ptVectorMean(T &m, const std::vector<const T *> &v);
@@ -82,6 +104,27 @@ void Dataset<T>::load(const std::string &listFileName,
     }
 }
 
+template <typename T>
+template <typename FileType>
+StatAccumulator<T> Dataset<T>::accumulate(const std::string &listFileName,
+                                          const std::string &dataName,
+                                          const bool trackCovariance)
+{
+    FileType                 file;
+    std::vector<std::string> dataFileName;
+    StatAccumulator<T>       acc(trackCovariance);
+
+    dataFileName = readManifest(listFileName);
+    for (const std::string &fileName: dataFileName)
+    {
+        file.open(fileName, File::Mode::read);
+        acc.push(file.template read<T>(dataName));
+        file.close();
+    }
+
+    return acc;
+}
+
 // resampling //////////////////////////////////////////////////////////////////
 template <typename T>
 Sample<T> Dataset<T>::bootstrapMean(const Index nSample, const SeedType seed)
@@ -133,6 +176,127 @@ void Dataset<T>::dumpBootstrapSeq(std::ostream &out, const Index nSample,
     }
 }
 
+template <typename T>
+Sample<T> Dataset<T>::parallelBootstrapMean(const Index nSample,
+                                            const SeedType seed,
+                                            const unsigned int nThread)
+{
+    const Index                     n = this->size();
+    Index                           nt;
+    Sample<T>                       s(nSample);
+    std::vector<std::thread>        worker;
+    std::vector<std::exception_ptr> error;
+    std::vector<const T *>          data(n);
+
+    for (Index j = 0; j < n; ++j)
+    {
+        data[j] = &((*this)[j]);
+    }
+    ptVectorMean(s[central], data);
+    nt = std::min(static_cast<Index>(nThread), nSample);
+    nt = std::max(nt, static_cast<Index>(1));
+    error.resize(nt);
+
+    // each thread computes a contiguous block of samples
+    auto work = [this, &s, &error, nSample, nt, n, seed](const Index t)
+    {
+        std::vector<const T *> d(n);
+
+        try
+        {
+            for (Index i = t*nSample/nt; i < (t + 1)*nSample/nt; ++i)
+            {
+                for (Index j = 0; j < n; ++j)
+                {
+                    d[j] = &((*this)[counterBootstrapIndex(seed, i, j, n)]);
+                }
+                ptVectorMean(s[i], d);
+            }
+        }
+        catch (...)
+        {
+            error[t] = std::current_exception();
+        }
+    };
+
+    for (Index t = 1; t < nt; ++t)
+    {
+        worker.emplace_back(work, t);
+    }
+    work(0);
+    for (auto &w: worker)
+    {
+        w.join();
+    }
+    for (auto &e: error)
+    {
+        if (e)
+        {
+            std::rethrow_exception(e);
+        }
+    }
+
+    return s;
+}
+
+template <typename T>
+void Dataset<T>::dumpParallelBootstrapSeq(std::ostream &out,
+                                          const Index nSample,
+                                          const SeedType seed)
+{
+    const Index n = this->size();
+
+    for (Index i = 0; i < nSample; ++i)
+    {
+        for (Index j = 0; j < n; ++j)
+        {
+            out << counterBootstrapIndex(seed, i, j, n) << " " << std::endl;
+        }
+        out << std::endl;
+    }
+}
+
+template <typename T>
+Sample<T> Dataset<T>::jackknifeMean(const Index blockSize)
+{
+    Index nBlock, n;
+    T     sum, blockSum;
+
+    if (blockSize < 1)
+    {
+        LATAN_ERROR(Argument, "jackknife block size must be positive");
+    }
+    nBlock = this->size()/blockSize;
+    n      = nBlock*blockSize;
+    if (nBlock < 2)
+    {
+        LATAN_ERROR(Size, "jackknife resampling needs at least 2 blocks");
+    }
+
+    Sample<T> s(nBlock);
+
+    sum = (*this)[0];
+    for (Index j = 1; j < n; ++j)
+    {
+        sum += (*this)[j];
+    }
+    s[central] = sum/static_cast<double>(n);
+    for (Index k = 0; k < nBlock; ++k)
+    {
+        const Index start = k*blockSize;
+
+        blockSum = (*this)[start];
+        for (Index j = start + 1; j < start + blockSize; ++j)
+        {
+            blockSum += (*this)[j];
+        }
+        s[k] = (sum - blockSum)/static_cast<double>(n - blockSize);
+    }
+    s.setResampling(Resampling::jackknife);
+
+    return s;
+}
+
 template <typename T>
 void Dataset<T>::ptVectorMean(T &m, const std::vector<const T *> &v)
 {
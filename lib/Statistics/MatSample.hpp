@@ -26,13 +26,14 @@
 
 BEGIN_LATAN_NAMESPACE
 
+template <typename Derived>
+class MatSampleExpr;
+template <typename T>
+class MatSampleRef;
+
 /******************************************************************************
  *                          matrix sample class                               *
  ******************************************************************************/
-#define SCAL_OP_RETURN(op, s, x) s.unaryExpr(\
-                                    std::bind(MatSample<T>::scalar##op,\
-                                    std::placeholders::_1, x))
-
 template <typename T>
 class MatSample: public Sample<Mat<T>>
 {
@@ -75,10 +76,16 @@ public:
     MatSample(const Index nSample, const Index nRow, const Index nCol);
     MatSample(ConstBlock &sampleBlock);
     MatSample(ConstBlock &&sampleBlock);
+    MatSample(const Sample<Mat<T>> &sample);
+    template <typename Derived>
+    MatSample(const MatSampleExpr<Derived> &e);
     EIGEN_EXPR_CTOR(MatSample, MatSample<T>, Sample<Mat<T>>, ArrayExpr)
     // destructor
     virtual ~MatSample(void) = default;
     // assignement operator
+    MatSample<T> & operator=(const Sample<Mat<T>> &sample);
+    template <typename Derived>
+    MatSample<T> & operator=(const MatSampleExpr<Derived> &e);
     MatSample<T> & operator=(Block &sampleBlock);
     MatSample<T> & operator=(Block &&sampleBlock);
     MatSample<T> & operator=(ConstBlock &sampleBlock);
@@ -103,47 +110,57 @@ public:
                      const Index nCol);
     // resize all matrices
     void resizeMat(const Index nRow, const Index nCol);
+    // fused expression view, see MatSampleExpr
+    MatSampleRef<T> expr(void) const;
 };
 
-// non-member operators
+// non-member operators, the result is a sample with the resampling scheme of s
 template <typename T>
-inline auto operator*(MatSample<T> s, const T &x)
-                      ->decltype(SCAL_OP_RETURN(Mul, s, x))
+inline MatSample<T> operator*(MatSample<T> s, const T &x)
 {
-    return SCAL_OP_RETURN(Mul, s, x);
+    s *= x;
+
+    return s;
 }
 
 template <typename T>
-inline auto operator*(MatSample<T> s, const T &&x)
-                      ->decltype(SCAL_OP_RETURN(Mul, s, x))
+inline MatSample<T> operator*(MatSample<T> s, const T &&x)
 {
-    return SCAL_OP_RETURN(Mul, s, x);
+    s *= x;
+
+    return s;
 }
 
 template <typename T>
-inline auto operator*(const T &x, MatSample<T> s)->decltype(s*x)
+inline MatSample<T> operator*(const T &x, MatSample<T> s)
 {
-    return s*x;
+    s *= x;
+
+    return s;
 }
 
 template <typename T>
-inline auto operator*(const T &&x, MatSample<T> s)->decltype(s*x)
+inline MatSample<T> operator*(const T &&x, MatSample<T> s)
 {
-    return s*x;
+    s *= x;
+
+    return s;
 }
 
 template <typename T>
-inline auto operator/(MatSample<T> s, const T &x)
-                      ->decltype(SCAL_OP_RETURN(Div, s, x))
+inline MatSample<T> operator/(MatSample<T> s, const T &x)
 {
-    return SCAL_OP_RETURN(Div, s, x);
+    s /= x;
+
+    return s;
 }
 
 template <typename T>
-inline auto operator/(MatSample<T> s, const T &&x)
-                      ->decltype(SCAL_OP_RETURN(Div, s, x))
+inline MatSample<T> operator/(MatSample<T> s, const T &&x)
 {
-    return SCAL_OP_RETURN(Div, s, x);
+    s /= x;
+
+    return s;
 }
 
 // type aliases
@@ -274,6 +291,7 @@ MatSample<T>::MatSample(ConstBlock &sampleBlock)
     const MatSample<T> &sample = sampleBlock.getSample();
     
     this->resize(sample.size());
+    this->setResampling(sample.getResampling());
     FOR_STAT_ARRAY(*this, s)
     {
         (*this)[s] = sample[s].block(sampleBlock.getStartRow(),
@@ -288,13 +306,55 @@ MatSample<T>::MatSample(ConstBlock &&sampleBlock)
 : MatSample(sampleBlock)
 {}
 
+// the sample conversions keep the resampling scheme, a sample constructed from
+// a raw Eigen expression is a bootstrap sample (see StatArray)
+template <typename T>
+MatSample<T>::MatSample(const Sample<Mat<T>> &sample)
+: Sample<Mat<T>>(sample)
+{}
+
+template <typename T>
+template <typename Derived>
+MatSample<T>::MatSample(const MatSampleExpr<Derived> &e)
+{
+    *this = e;
+}
+
 // assignement operator ////////////////////////////////////////////////////////
+template <typename T>
+MatSample<T> & MatSample<T>::operator=(const Sample<Mat<T>> &sample)
+{
+    Sample<Mat<T>>::operator=(sample);
+
+    return *this;
+}
+
+// the expression is evaluated sample by sample directly into the matrices of
+// this sample, the sample s of the expression only depends on the samples s
+// of its operands so it can contain this sample
+template <typename T>
+template <typename Derived>
+MatSample<T> & MatSample<T>::operator=(const MatSampleExpr<Derived> &e)
+{
+    const Derived &d = e.derived();
+
+    this->setResampling(d.getResampling());
+    this->resize(d.size());
+    FOR_STAT_ARRAY(*this, s)
+    {
+        (*this)[s] = d[s];
+    }
+
+    return *this;
+}
+
 template <typename T>
 MatSample<T> & MatSample<T>::operator=(Block &sampleBlock)
 {
     MatSample<T> tmp(sampleBlock);
     
     this->swap(tmp);
+    this->setResampling(tmp.getResampling());
     
     return *this;
 }
@@ -313,6 +373,7 @@ MatSample<T> & MatSample<T>::operator=(ConstBlock &sampleBlock)
     MatSample<T> tmp(sampleBlock);
     
     this->swap(tmp);
+    this->setResampling(tmp.getResampling());
     
     return *this;
 }
@@ -329,25 +390,25 @@ MatSample<T> & MatSample<T>::operator=(ConstBlock &&sampleBlock)
 template <typename T>
 MatSample<T> & MatSample<T>::operator*=(const T &x)
 {
-    return *this = (*this)*x;
+    return *this = expr()*x;
 }
 
 template <typename T>
 MatSample<T> & MatSample<T>::operator*=(const T &&x)
 {
-    return *this = (*this)*x;
+    return *this = expr()*x;
 }
 
 template <typename T>
 MatSample<T> & MatSample<T>::operator/=(const T &x)
 {
-    return *this = (*this)/x;
+    return *this = expr()/x;
 }
 
 template <typename T>
 MatSample<T> & MatSample<T>::operator/=(const T &&x)
 {
-    return *this = (*this)/x;
+    return *this = expr()/x;
 }
 
 // block access ////////////////////////////////////////////////////////////////
@@ -379,6 +440,335 @@ void MatSample<T>::resizeMat(const Index nRow, const Index nCol)
     }
 }
 
+// fused expression view ///////////////////////////////////////////////////////
+template <typename T>
+MatSampleRef<T> MatSample<T>::expr(void) const
+{
+    return MatSampleRef<T>(*this);
+}
+
+/******************************************************************************
+ *                   matrix sample expression templates                       *
+ ******************************************************************************/
+// arithmetic on whole matrix samples (e.g. (a.expr()*b - c)/x) builds a tree
+// of lightweight nodes instead of one temporary sample per operator; the node
+// operator[](s) returns the Eigen expression of the sample s and assigning the
+// tree to a MatSample evaluates each sample in a single Eigen assignment; the
+// operators have the same meaning as for Mat (* between matrix samples is the
+// matrix product of each sample), and a Sample<T> operand is a scalar with a
+// different value for each sample
+namespace SampleOp
+{
+    struct Add
+    {
+        template <typename A, typename B>
+        static auto apply(const A &a, const B &b)->decltype(a + b)
+        {
+            return a + b;
+        }
+    };
+
+    struct Sub
+    {
+        template <typename A, typename B>
+        static auto apply(const A &a, const B &b)->decltype(a - b)
+        {
+            return a - b;
+        }
+    };
+
+    struct Mul
+    {
+        template <typename A, typename B>
+        static auto apply(const A &a, const B &b)->decltype(a*b)
+        {
+            return a*b;
+        }
+    };
+
+    struct Div
+    {
+        template <typename A, typename B>
+        static auto apply(const A &a, const B &b)->decltype(a/b)
+        {
+            return a/b;
+        }
+    };
+
+    struct Neg
+    {
+        template <typename A>
+        static auto apply(const A &a)->decltype(-a)
+        {
+            return -a;
+        }
+    };
+}
+
+// expression base
+template <typename Derived>
+class MatSampleExpr
+{
+public:
+    const Derived & derived(void) const
+    {
+        return *static_cast<const Derived *>(this);
+    }
+};
+
+// leaf referencing a matrix sample
+template <typename T>
+class MatSampleRef: public MatSampleExpr<MatSampleRef<T>>
+{
+public:
+    typedef T Scalar;
+public:
+    // constructor
+    explicit MatSampleRef(const MatSample<T> &sample)
+    : sample_(sample)
+    {}
+    // access
+    Index size(void) const
+    {
+        return sample_.size();
+    }
+    Resampling getResampling(void) const
+    {
+        return sample_.getResampling();
+    }
+    const Mat<T> & operator[](const Index s) const
+    {
+        return sample_[s];
+    }
+private:
+    const MatSample<T> &sample_;
+};
+
+// scalar operands, constant or one value per sample
+template <typename T>
+class SampleScalarConst
+{
+public:
+    explicit SampleScalarConst(const T &x)
+    : x_(x)
+    {}
+    const T & operator[](const Index s __dumb) const
+    {
+        return x_;
+    }
+    void check(const Index size __dumb, const Resampling r __dumb) const
+    {}
+private:
+    const T x_;
+};
+
+template <typename T>
+class SampleScalarRef
+{
+public:
+    explicit SampleScalarRef(const Sample<T> &sample)
+    : sample_(sample)
+    {}
+    const T & operator[](const Index s) const
+    {
+        return sample_[s];
+    }
+    void check(const Index size, const Resampling r) const
+    {
+        if (sample_.size() != size)
+        {
+            LATAN_ERROR(Size, "sample size mismatch");
+        }
+        if (sample_.getResampling() != r)
+        {
+            LATAN_ERROR(Argument, "operation between samples with different "
+                        "resampling schemes");
+        }
+    }
+private:
+    const Sample<T> &sample_;
+};
+
+// operation between two matrix sample expressions
+template <typename Op, typename L, typename R>
+class MatSampleBinaryExpr: public MatSampleExpr<MatSampleBinaryExpr<Op, L, R>>
+{
+public:
+    typedef typename L::Scalar Scalar;
+public:
+    // constructor
+    MatSampleBinaryExpr(const L &lhs, const R &rhs)
+    : lhs_(lhs), rhs_(rhs)
+    {
+        if (lhs_.size() != rhs_.size())
+        {
+            LATAN_ERROR(Size, "sample size mismatch");
+        }
+        if (lhs_.getResampling() != rhs_.getResampling())
+        {
+            LATAN_ERROR(Argument, "operation between samples with different "
+                        "resampling schemes");
+        }
+    }
+    // access
+    Index size(void) const
+    {
+        return lhs_.size();
+    }
+    Resampling getResampling(void) const
+    {
+        return lhs_.getResampling();
+    }
+    auto operator[](const Index s) const
+    ->decltype(Op::apply(std::declval<const L &>()[s],
+                         std::declval<const R &>()[s]))
+    {
+        return Op::apply(lhs_[s], rhs_[s]);
+    }
+private:
+    const L lhs_;
+    const R rhs_;
+};
+
+// operation between a matrix sample expression and a scalar operand
+template <typename Op, typename E, typename S>
+class MatSampleScalarExpr: public MatSampleExpr<MatSampleScalarExpr<Op, E, S>>
+{
+public:
+    typedef typename E::Scalar Scalar;
+public:
+    // constructor
+    MatSampleScalarExpr(const E &expr, const S &x)
+    : expr_(expr), x_(x)
+    {
+        x_.check(expr_.size(), expr_.getResampling());
+    }
+    // access
+    Index size(void) const
+    {
+        return expr_.size();
+    }
+    Resampling getResampling(void) const
+    {
+        return expr_.getResampling();
+    }
+    auto operator[](const Index s) const
+    ->decltype(Op::apply(std::declval<const E &>()[s],
+                         std::declval<const S &>()[s]))
+    {
+        return Op::apply(expr_[s], x_[s]);
+    }
+private:
+    const E expr_;
+    const S x_;
+};
+
+// unary operation on a matrix sample expression
+template <typename Op, typename E>
+class MatSampleUnaryExpr: public MatSampleExpr<MatSampleUnaryExpr<Op, E>>
+{
+public:
+    typedef typename E::Scalar Scalar;
+public:
+    // constructor
+    explicit MatSampleUnaryExpr(const E &expr)
+    : expr_(expr)
+    {}
+    // access
+    Index size(void) const
+    {
+        return expr_.size();
+    }
+    Resampling getResampling(void) const
+    {
+        return expr_.getResampling();
+    }
+    auto operator[](const Index s) const
+    ->decltype(Op::apply(std::declval<const E &>()[s]))
+    {
+        return Op::apply(expr_[s]);
+    }
+private:
+    const E expr_;
+};
+
+// expression operators, a MatSample operand is referenced when the other
+// operand is an expression
+#define MAKE_SAMPLE_EXPR_BIN_OP(op, name)\
+template <typename L, typename R>\
+inline MatSampleBinaryExpr<SampleOp::name, L, R>\
+operator op(const MatSampleExpr<L> &lhs, const MatSampleExpr<R> &rhs)\
+{\
+    return MatSampleBinaryExpr<SampleOp::name, L, R>(lhs.derived(),\
+                                                     rhs.derived());\
+}\
+template <typename L>\
+inline MatSampleBinaryExpr<SampleOp::name, L,\
+                           MatSampleRef<typename L::Scalar>>\
+operator op(const MatSampleExpr<L> &lhs,\
+            const MatSample<typename L::Scalar> &rhs)\
+{\
+    return lhs op rhs.expr();\
+}\
+template <typename R>\
+inline MatSampleBinaryExpr<SampleOp::name,\
+                           MatSampleRef<typename R::Scalar>, R>\
+operator op(const MatSample<typename R::Scalar> &lhs,\
+            const MatSampleExpr<R> &rhs)\
+{\
+    return lhs.expr() op rhs;\
+}
+
+#define MAKE_SAMPLE_EXPR_SCAL_OP(op, name)\
+template <typename E>\
+inline MatSampleScalarExpr<SampleOp::name, E,\
+                           SampleScalarConst<typename E::Scalar>>\
+operator op(const MatSampleExpr<E> &e, const typename E::Scalar &x)\
+{\
+    typedef SampleScalarConst<typename E::Scalar> S;\
+    \
+    return MatSampleScalarExpr<SampleOp::name, E, S>(e.derived(), S(x));\
+}\
+template <typename E>\
+inline MatSampleScalarExpr<SampleOp::name, E,\
+                           SampleScalarRef<typename E::Scalar>>\
+operator op(const MatSampleExpr<E> &e, const Sample<typename E::Scalar> &x)\
+{\
+    typedef SampleScalarRef<typename E::Scalar> S;\
+    \
+    return MatSampleScalarExpr<SampleOp::name, E, S>(e.derived(), S(x));\
+}
+
+MAKE_SAMPLE_EXPR_BIN_OP(+, Add)
+MAKE_SAMPLE_EXPR_BIN_OP(-, Sub)
+MAKE_SAMPLE_EXPR_BIN_OP(*, Mul)
+MAKE_SAMPLE_EXPR_SCAL_OP(*, Mul)
+MAKE_SAMPLE_EXPR_SCAL_OP(/, Div)
+
+#undef MAKE_SAMPLE_EXPR_BIN_OP
+#undef MAKE_SAMPLE_EXPR_SCAL_OP
+
+// scalars commute with matrices
+template <typename E>
+inline auto operator*(const typename E::Scalar &x, const MatSampleExpr<E> &e)
+->decltype(e*x)
+{
+    return e*x;
+}
+
+template <typename E>
+inline auto operator*(const Sample<typename E::Scalar> &x,
+                      const MatSampleExpr<E> &e)->decltype(e*x)
+{
+    return e*x;
+}
+
+template <typename E>
+inline MatSampleUnaryExpr<SampleOp::Neg, E>
+operator-(const MatSampleExpr<E> &e)
+{
+    return MatSampleUnaryExpr<SampleOp::Neg, E>(e.derived());
+}
 
 END_LATAN_NAMESPACE
 
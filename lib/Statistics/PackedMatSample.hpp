@@ -0,0 +1,471 @@
+/*
+ * PackedMatSample.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_PackedMatSample_hpp_
+#define Latan_PackedMatSample_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Statistics/MatSample.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                      packed matrix sample class                            *
+ ******************************************************************************/
+// matrix sample stored in a single column-major buffer of size
+// (nRow*nCol) x (nSample + 1), the column s + 1 holding the matrix of the
+// sample s (column 0 is the central value); operator[] returns Map views on
+// the buffer so that the usual sample loops (FOR_STAT_ARRAY) work unchanged,
+// and the whole-sample operations are dense matrix kernels on the buffer
+template <typename T>
+class PackedMatSample
+{
+public:
+    typedef MatBase<T>                   Buffer;
+    typedef Eigen::Map<MatBase<T>>       MatView;
+    typedef Eigen::Map<const MatBase<T>> ConstMatView;
+    // block of all the samples, assignable from a packed sample
+    class Block
+    {
+    public:
+        // constructor
+        Block(PackedMatSample<T> &sample, const Index i, const Index j,
+              const Index nRow, const Index nCol);
+        // destructor
+        ~Block(void) = default;
+        // assignement operator
+        Block & operator=(const PackedMatSample<T> &sample);
+        // conversion
+        operator PackedMatSample<T>(void) const;
+    private:
+        PackedMatSample<T> &sample_;
+        const Index        i_, j_, nRow_, nCol_;
+    };
+public:
+    // constructors
+    PackedMatSample(void) = default;
+    PackedMatSample(const Index nSample, const Index nRow, const Index nCol);
+    explicit PackedMatSample(const MatSample<T> &sample);
+    // destructor
+    ~PackedMatSample(void) = default;
+    // access
+    Index          size(void) const;
+    Index          getNRow(void) const;
+    Index          getNCol(void) const;
+    void           resize(const Index nSample, const Index nRow,
+                          const Index nCol);
+    Buffer &       getBuffer(void);
+    const Buffer & getBuffer(void) const;
+    MatSample<T>   toMatSample(void) const;
+    Resampling     getResampling(void) const;
+    void           setResampling(const Resampling resampling);
+    // sample views
+    MatView      operator[](const Index s);
+    ConstMatView operator[](const Index s) const;
+    // block access
+    PackedMatSample<T> block(const Index i, const Index j, const Index nRow,
+                             const Index nCol) const;
+    Block              block(const Index i, const Index j, const Index nRow,
+                             const Index nCol);
+    // arithmetic operators
+    PackedMatSample<T> & operator+=(const PackedMatSample<T> &sample);
+    PackedMatSample<T> & operator-=(const PackedMatSample<T> &sample);
+    PackedMatSample<T> & operator*=(const T &x);
+    PackedMatSample<T> & operator/=(const T &x);
+    // statistics, same estimators as StatArray for the resampling scheme; the
+    // second factor of the (co)variances is conjugated, so that the variance
+    // of complex data is real and matches the diagonal of varianceMatrix
+    Mat<T> mean(void) const;
+    Mat<T> variance(void) const;
+    Mat<T> covarianceMatrix(const PackedMatSample<T> &sample) const;
+    Mat<T> varianceMatrix(void) const;
+    Mat<T> correlationMatrix(void) const;
+private:
+    // error checking
+    void checkSize(const PackedMatSample<T> &sample) const;
+    void checkVector(void) const;
+    // samples minus their mean, as columns
+    Buffer centered(void) const;
+public:
+    static constexpr Index offset = 1;
+private:
+    Index      nRow_{0}, nCol_{0};
+    Buffer     buffer_{Buffer::Zero(0, 1)};
+    Resampling resampling_{Resampling::bootstrap};
+};
+
+// non-member operators
+template <typename T>
+inline PackedMatSample<T> operator+(PackedMatSample<T> lhs,
+                                    const PackedMatSample<T> &rhs)
+{
+    lhs += rhs;
+
+    return lhs;
+}
+
+template <typename T>
+inline PackedMatSample<T> operator-(PackedMatSample<T> lhs,
+                                    const PackedMatSample<T> &rhs)
+{
+    lhs -= rhs;
+
+    return lhs;
+}
+
+template <typename T>
+inline PackedMatSample<T> operator*(PackedMatSample<T> s, const T &x)
+{
+    s *= x;
+
+    return s;
+}
+
+template <typename T>
+inline PackedMatSample<T> operator*(const T &x, PackedMatSample<T> s)
+{
+    s *= x;
+
+    return s;
+}
+
+template <typename T>
+inline PackedMatSample<T> operator/(PackedMatSample<T> s, const T &x)
+{
+    s /= x;
+
+    return s;
+}
+
+// type aliases
+typedef PackedMatSample<double>               DPackedMatSample;
+typedef PackedMatSample<std::complex<double>> CPackedMatSample;
+
+/******************************************************************************
+ *                 PackedMatSample::Block implementation                      *
+ ******************************************************************************/
+template <typename T>
+PackedMatSample<T>::Block::Block(PackedMatSample<T> &sample, const Index i,
+                                 const Index j, const Index nRow,
+                                 const Index nCol)
+: sample_(sample)
+, i_(i)
+, j_(j)
+, nRow_(nRow)
+, nCol_(nCol)
+{}
+
+template <typename T>
+typename PackedMatSample<T>::Block &
+PackedMatSample<T>::Block::operator=(const PackedMatSample<T> &sample)
+{
+    if ((sample.size() != sample_.size()) or (sample.getNRow() != nRow_)
+        or (sample.getNCol() != nCol_))
+    {
+        LATAN_ERROR(Size, "packed sample block size mismatch");
+    }
+    FOR_STAT_ARRAY(sample_, s)
+    {
+        sample_[s].block(i_, j_, nRow_, nCol_) = sample[s];
+    }
+
+    return *this;
+}
+
+template <typename T>
+PackedMatSample<T>::Block::operator PackedMatSample<T>(void) const
+{
+    const PackedMatSample<T> &sample = sample_;
+
+    return sample.block(i_, j_, nRow_, nCol_);
+}
+
+/******************************************************************************
+ *                 PackedMatSample template implementation                    *
+ ******************************************************************************/
+// constructors ////////////////////////////////////////////////////////////////
+template <typename T>
+PackedMatSample<T>::PackedMatSample(const Index nSample, const Index nRow,
+                                    const Index nCol)
+{
+    resize(nSample, nRow, nCol);
+}
+
+template <typename T>
+PackedMatSample<T>::PackedMatSample(const MatSample<T> &sample)
+: PackedMatSample(sample.size(), sample[central].rows(),
+                  sample[central].cols())
+{
+    resampling_ = sample.getResampling();
+    FOR_STAT_ARRAY(sample, s)
+    {
+        (*this)[s] = sample[s];
+    }
+}
+
+// access //////////////////////////////////////////////////////////////////////
+template <typename T>
+Index PackedMatSample<T>::size(void) const
+{
+    return buffer_.cols() - offset;
+}
+
+template <typename T>
+Index PackedMatSample<T>::getNRow(void) const
+{
+    return nRow_;
+}
+
+template <typename T>
+Index PackedMatSample<T>::getNCol(void) const
+{
+    return nCol_;
+}
+
+template <typename T>
+void PackedMatSample<T>::resize(const Index nSample, const Index nRow,
+                                const Index nCol)
+{
+    nRow_ = nRow;
+    nCol_ = nCol;
+    buffer_.resize(nRow*nCol, nSample + offset);
+}
+
+template <typename T>
+typename PackedMatSample<T>::Buffer & PackedMatSample<T>::getBuffer(void)
+{
+    return buffer_;
+}
+
+template <typename T>
+const typename PackedMatSample<T>::Buffer &
+PackedMatSample<T>::getBuffer(void) const
+{
+    return buffer_;
+}
+
+template <typename T>
+MatSample<T> PackedMatSample<T>::toMatSample(void) const
+{
+    MatSample<T> sample(size(), nRow_, nCol_);
+
+    sample.setResampling(resampling_);
+    FOR_STAT_ARRAY(sample, s)
+    {
+        sample[s] = (*this)[s];
+    }
+
+    return sample;
+}
+
+template <typename T>
+Resampling PackedMatSample<T>::getResampling(void) const
+{
+    return resampling_;
+}
+
+template <typename T>
+void PackedMatSample<T>::setResampling(const Resampling resampling)
+{
+    resampling_ = resampling;
+}
+
+// sample views ////////////////////////////////////////////////////////////////
+template <typename T>
+inline typename PackedMatSample<T>::MatView
+PackedMatSample<T>::operator[](const Index s)
+{
+    return MatView(buffer_.col(s + offset).data(), nRow_, nCol_);
+}
+
+template <typename T>
+inline typename PackedMatSample<T>::ConstMatView
+PackedMatSample<T>::operator[](const Index s) const
+{
+    return ConstMatView(buffer_.col(s + offset).data(), nRow_, nCol_);
+}
+
+// block access ////////////////////////////////////////////////////////////////
+template <typename T>
+PackedMatSample<T> PackedMatSample<T>::block(const Index i, const Index j,
+                                             const Index nRow,
+                                             const Index nCol) const
+{
+    PackedMatSample<T> res(size(), nRow, nCol);
+
+    res.resampling_ = resampling_;
+    FOR_STAT_ARRAY(res, s)
+    {
+        res[s] = (*this)[s].block(i, j, nRow, nCol);
+    }
+
+    return res;
+}
+
+template <typename T>
+typename PackedMatSample<T>::Block
+PackedMatSample<T>::block(const Index i, const Index j, const Index nRow,
+                          const Index nCol)
+{
+    return Block(*this, i, j, nRow, nCol);
+}
+
+// arithmetic operators ////////////////////////////////////////////////////////
+template <typename T>
+PackedMatSample<T> &
+PackedMatSample<T>::operator+=(const PackedMatSample<T> &sample)
+{
+    checkSize(sample);
+    buffer_ += sample.buffer_;
+
+    return *this;
+}
+
+template <typename T>
+PackedMatSample<T> &
+PackedMatSample<T>::operator-=(const PackedMatSample<T> &sample)
+{
+    checkSize(sample);
+    buffer_ -= sample.buffer_;
+
+    return *this;
+}
+
+template <typename T>
+PackedMatSample<T> & PackedMatSample<T>::operator*=(const T &x)
+{
+    buffer_ *= x;
+
+    return *this;
+}
+
+template <typename T>
+PackedMatSample<T> & PackedMatSample<T>::operator/=(const T &x)
+{
+    buffer_ /= x;
+
+    return *this;
+}
+
+// error checking //////////////////////////////////////////////////////////////
+template <typename T>
+void PackedMatSample<T>::checkSize(const PackedMatSample<T> &sample) const
+{
+    if ((sample.size() != size()) or (sample.nRow_ != nRow_)
+        or (sample.nCol_ != nCol_))
+    {
+        LATAN_ERROR(Size, "packed sample size mismatch");
+    }
+}
+
+template <typename T>
+void PackedMatSample<T>::checkVector(void) const
+{
+    if (nCol_ != 1)
+    {
+        LATAN_ERROR(Size, "tensorial product is only valid with column "
+                    "vectors");
+    }
+}
+
+// statistics //////////////////////////////////////////////////////////////////
+template <typename T>
+Mat<T> PackedMatSample<T>::mean(void) const
+{
+    Mat<T> res(nRow_, nCol_);
+
+    MatView(res.data(), nRow_*nCol_, 1) =
+        buffer_.rightCols(size()).rowwise().sum()/static_cast<double>(size());
+
+    return res;
+}
+
+template <typename T>
+typename PackedMatSample<T>::Buffer PackedMatSample<T>::centered(void) const
+{
+    Buffer m = buffer_.rightCols(size()).rowwise().sum()
+               /static_cast<double>(size());
+
+    return buffer_.rightCols(size()).colwise() - m.col(0);
+}
+
+template <typename T>
+Mat<T> PackedMatSample<T>::variance(void) const
+{
+    Mat<T> res(nRow_, nCol_);
+    Buffer c = centered();
+
+    MatView(res.data(), nRow_*nCol_, 1) =
+        c.cwiseAbs2().rowwise().sum().template cast<T>()
+        *resamplingNormalisation(resampling_, size());
+
+    return res;
+}
+
+template <typename T>
+Mat<T> PackedMatSample<T>::covarianceMatrix(const PackedMatSample<T> &sample)
+const
+{
+    checkSize(sample);
+    checkVector();
+    if (sample.resampling_ != resampling_)
+    {
+        LATAN_ERROR(Argument, "covariance between samples with different "
+                    "resampling schemes");
+    }
+
+    Mat<T> res;
+
+    res.noalias() = centered()*sample.centered().adjoint();
+    res          *= resamplingNormalisation(resampling_, size());
+
+    return res;
+}
+
+// the symmetric product only computes one triangle
+template <typename T>
+Mat<T> PackedMatSample<T>::varianceMatrix(void) const
+{
+    checkVector();
+
+    Mat<T> res = Mat<T>::Zero(nRow_, nRow_);
+
+    res.template selfadjointView<Eigen::Lower>()
+        .rankUpdate(centered(), resamplingNormalisation(resampling_, size()));
+    res.template triangularView<Eigen::StrictlyUpper>() = res.adjoint();
+
+    return res;
+}
+
+template <typename T>
+Mat<T> PackedMatSample<T>::correlationMatrix(void) const
+{
+    Mat<T> res = varianceMatrix();
+    Mat<T> invDiag(res.rows(), 1);
+
+    invDiag = res.diagonal();
+    invDiag = invDiag.cwiseInverse().cwiseSqrt();
+    res     = (invDiag*invDiag.transpose()).cwiseProduct(res);
+
+    return res;
+}
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_PackedMatSample_hpp_
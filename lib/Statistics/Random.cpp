@@ -54,3 +54,62 @@ DVec RandomNormal::operator()(void)
 
   return mean_ + transform_*buf_;
 }
+
+/******************************************************************************
+ *                       Philox4x32 implementation                            *
+ ******************************************************************************/
+Philox4x32::Counter Philox4x32::generate(Counter ctr, Key key)
+{
+  const uint32_t m0 = 0xD2511F53u, m1 = 0xCD9E8D57u;
+  const uint32_t w0 = 0x9E3779B9u, w1 = 0xBB67AE85u;
+
+  for (unsigned int r = 0; r < 10; ++r)
+  {
+    const uint64_t p0 = static_cast<uint64_t>(m0)*ctr[0];
+    const uint64_t p1 = static_cast<uint64_t>(m1)*ctr[2];
+
+    ctr = {{static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+            static_cast<uint32_t>(p1),
+            static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+            static_cast<uint32_t>(p0)}};
+    key[0] += w0;
+    key[1] += w1;
+  }
+
+  return ctr;
+}
+
+// Lemire's multiply-shift method with rejection, which is unbiased
+uint32_t Philox4x32::uniformInt(const Key &key, const uint32_t c0,
+                                const uint32_t c1, const uint32_t c2,
+                                const uint32_t n)
+{
+  const uint32_t threshold = (0u - n) % n;
+
+  for (uint32_t c3 = 0; ; ++c3)
+  {
+    Counter r = generate({{c0, c1, c2, c3}}, key);
+
+    for (auto x: r)
+    {
+      const uint64_t m = static_cast<uint64_t>(x)*n;
+
+      if (static_cast<uint32_t>(m) >= threshold)
+      {
+        return static_cast<uint32_t>(m >> 32);
+      }
+    }
+  }
+}
+
+uint32_t Latan::counterBootstrapIndex(const SeedType seed, const Index s,
+                                      const Index j, const Index n)
+{
+  const uint64_t ju = static_cast<uint64_t>(j);
+
+  return Philox4x32::uniformInt({{static_cast<uint32_t>(seed), 0u}},
+                                static_cast<uint32_t>(ju),
+                                static_cast<uint32_t>(ju >> 32),
+                                static_cast<uint32_t>(s),
+                                static_cast<uint32_t>(n));
+}
@@ -44,6 +44,31 @@ private:
   std::mt19937 gen_;
 };
 
+/******************************************************************************
+ *                  Counter-based RNG (Philox4x32-10)                         *
+ ******************************************************************************/
+// stateless generator (Salmon et al., SC'11): the output is a bijective
+// function of a 128-bit counter and a 64-bit key, so that any element of a
+// random sequence can be computed independently of the others
+class Philox4x32
+{
+public:
+  typedef std::array<uint32_t, 4> Counter;
+  typedef std::array<uint32_t, 2> Key;
+public:
+  // random block for the counter ctr and the key key
+  static Counter generate(Counter ctr, Key key);
+  // uniform integer in [0, n) for the key key and the counter words
+  // (c0, c1, c2), the last counter word is used to redraw rejected values
+  static uint32_t uniformInt(const Key &key, const uint32_t c0,
+                             const uint32_t c1, const uint32_t c2,
+                             const uint32_t n);
+};
+
+// bootstrap draw j of the sample s for a dataset of size n
+uint32_t counterBootstrapIndex(const SeedType seed, const Index s,
+                               const Index j, const Index n);
+
 END_LATAN_NAMESPACE
 
 #endif // Latan_Random_hpp_
@@ -0,0 +1,243 @@
+/*
+ * StatAccumulator.hpp, part of LatAnalyze 3
+ *
+ * Copyright (C) 2013 - 2020 Antonin Portelli
+ *
+ * LatAnalyze 3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LatAnalyze 3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LatAnalyze 3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Latan_StatAccumulator_hpp_
+#define Latan_StatAccumulator_hpp_
+
+#include <LatAnalyze/Global.hpp>
+#include <LatAnalyze/Core/Mat.hpp>
+#include <LatAnalyze/Statistics/StatArray.hpp>
+
+BEGIN_LATAN_NAMESPACE
+
+/******************************************************************************
+ *                    one-pass statistics accumulator                         *
+ ******************************************************************************/
+// mean, variance and optionally covariance matrix (column vector data only)
+// updated for each pushed value with Welford's algorithm, the memory does not
+// depend on the number of values; accumulators of disjoint data (e.g. built
+// by different threads) are combined with Chan et al. pairwise formulas; the
+// estimators are the same as StatArray
+template <typename T>
+class StatAccumulator
+{
+public:
+    // constructor
+    explicit StatAccumulator(const bool trackCovariance = false);
+    // destructor
+    ~StatAccumulator(void) = default;
+    // access
+    Index size(void) const;
+    bool  isCovarianceTracked(void) const;
+    void  reset(void);
+    // accumulation
+    void                 push(const T &x);
+    void                 merge(const StatAccumulator<T> &acc);
+    StatAccumulator<T> & operator+=(const StatAccumulator<T> &acc);
+    // statistics
+    T mean(void) const;
+    T variance(void) const;
+    T varianceMatrix(void) const;
+    T correlationMatrix(void) const;
+private:
+    static double zero(const double &x);
+    template <typename U>
+    static Mat<U> zero(const Mat<U> &x);
+    void          checkNonEmpty(void) const;
+private:
+    bool  trackCov_;
+    Index n_{0};
+    T     mean_, m2_, c_;
+};
+
+/******************************************************************************
+ *                StatAccumulator template implementation                     *
+ ******************************************************************************/
+// constructor /////////////////////////////////////////////////////////////////
+template <typename T>
+StatAccumulator<T>::StatAccumulator(const bool trackCovariance)
+: trackCov_(trackCovariance)
+{}
+
+// access //////////////////////////////////////////////////////////////////////
+template <typename T>
+Index StatAccumulator<T>::size(void) const
+{
+    return n_;
+}
+
+template <typename T>
+bool StatAccumulator<T>::isCovarianceTracked(void) const
+{
+    return trackCov_;
+}
+
+template <typename T>
+void StatAccumulator<T>::reset(void)
+{
+    n_ = 0;
+}
+
+template <typename T>
+double StatAccumulator<T>::zero(const double &x __dumb)
+{
+    return 0.;
+}
+
+template <typename T>
+template <typename U>
+Mat<U> StatAccumulator<T>::zero(const Mat<U> &x)
+{
+    return Mat<U>::Zero(x.rows(), x.cols());
+}
+
+template <typename T>
+void StatAccumulator<T>::checkNonEmpty(void) const
+{
+    if (n_ == 0)
+    {
+        LATAN_ERROR(Size, "statistics of an empty accumulator");
+    }
+}
+
+// accumulation ////////////////////////////////////////////////////////////////
+template <typename T>
+void StatAccumulator<T>::push(const T &x)
+{
+    if (n_ == 0)
+    {
+        // the tensor product checks the data shape, before any state change
+        T c;
+
+        if (trackCov_)
+        {
+            c = zero(ReducOp::tensProd(x, x));
+        }
+        n_    = 1;
+        mean_ = x;
+        m2_   = zero(ReducOp::prod(x, x));
+        if (trackCov_)
+        {
+            c_ = c;
+        }
+    }
+    else
+    {
+        T delta, delta2;
+
+        n_++;
+        delta  = x - mean_;
+        mean_ += delta/static_cast<double>(n_);
+        delta2 = x - mean_;
+        m2_   += ReducOp::prod(delta, delta2);
+        if (trackCov_)
+        {
+            c_ += ReducOp::tensProd(delta, delta2);
+        }
+    }
+}
+
+template <typename T>
+void StatAccumulator<T>::merge(const StatAccumulator<T> &acc)
+{
+    if (acc.trackCov_ != trackCov_)
+    {
+        LATAN_ERROR(Argument, "merging accumulators with and without "
+                    "covariance");
+    }
+    if (acc.n_ == 0)
+    {
+        return;
+    }
+    if (n_ == 0)
+    {
+        *this = acc;
+
+        return;
+    }
+
+    const double na = static_cast<double>(n_), nb = static_cast<double>(acc.n_);
+    const double n  = na + nb;
+    T            delta;
+
+    delta  = acc.mean_ - mean_;
+    mean_ += delta*(nb/n);
+    m2_   += acc.m2_ + ReducOp::prod(delta, delta)*(na*nb/n);
+    if (trackCov_)
+    {
+        c_ += acc.c_ + ReducOp::tensProd(delta, delta)*(na*nb/n);
+    }
+    n_ += acc.n_;
+}
+
+template <typename T>
+StatAccumulator<T> & StatAccumulator<T>::operator+=(
+    const StatAccumulator<T> &acc)
+{
+    merge(acc);
+
+    return *this;
+}
+
+// statistics //////////////////////////////////////////////////////////////////
+template <typename T>
+T StatAccumulator<T>::mean(void) const
+{
+    checkNonEmpty();
+
+    return mean_;
+}
+
+template <typename T>
+T StatAccumulator<T>::variance(void) const
+{
+    checkNonEmpty();
+
+    return m2_/static_cast<double>(n_ - 1);
+}
+
+template <typename T>
+T StatAccumulator<T>::varianceMatrix(void) const
+{
+    checkNonEmpty();
+    if (!trackCov_)
+    {
+        LATAN_ERROR(Definition, "covariance is not tracked by this "
+                    "accumulator");
+    }
+
+    return c_/static_cast<double>(n_ - 1);
+}
+
+template <typename T>
+T StatAccumulator<T>::correlationMatrix(void) const
+{
+    T res = varianceMatrix();
+    T invDiag(res.rows(), 1);
+
+    invDiag = res.diagonal();
+    invDiag = invDiag.cwiseInverse().cwiseSqrt();
+    res     = (invDiag*invDiag.transpose()).cwiseProduct(res);
+
+    return res;
+}
+
+END_LATAN_NAMESPACE
+
+#endif // Latan_StatAccumulator_hpp_
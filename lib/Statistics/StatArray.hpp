@@ -28,9 +28,36 @@ for (Latan::Index i = -(ar).offset; i < (ar).size(); ++i)
 
 BEGIN_LATAN_NAMESPACE
 
+// resampling scheme, it sets the normalisation of the sample (co)variance
+// estimators: 1/(n - 1) for the bootstrap and (n - 1)/n for the (blocked)
+// jackknife, where n is the number of samples
+enum class Resampling
+{
+    bootstrap = 0,
+    jackknife = 1
+};
+
+inline double resamplingNormalisation(const Resampling resampling,
+                                      const Index n)
+{
+    const double dn = static_cast<double>(n);
+
+    switch (resampling)
+    {
+        case Resampling::jackknife:
+            return (dn - 1.)/dn;
+        default:
+            return 1./(dn - 1.);
+    }
+}
+
 /******************************************************************************
  *                     Array class with statistics                            *
  ******************************************************************************/
+// the resampling scheme is copied and moved with the array, it is not part of
+// the Eigen base: an array constructed from a raw Eigen expression (e.g. 2.*s)
+// is a bootstrap array and assigning an expression keeps the scheme of the
+// target, use setResampling or the MatSample expressions to propagate it
 template <typename T, Index os = 0>
 class StatArray: public Array<T, dynamic, 1>, public IoObject
 {
@@ -44,8 +71,10 @@ public:
     // destructor
     virtual ~StatArray(void) = default;
     // access
-    Index size(void) const;
-    void  resize(const Index size);
+    Index      size(void) const;
+    void       resize(const Index size);
+    Resampling getResampling(void) const;
+    void       setResampling(const Resampling resampling);
     // operators
           T & operator[](const Index s);
     const T & operator[](const Index s) const;
@@ -63,6 +92,8 @@ public:
     virtual IoType getType(void) const;
 public:
     static constexpr Index offset = os;
+private:
+    Resampling resampling_{Resampling::bootstrap};
 };
 
 // reduction operations
@@ -77,6 +108,19 @@ namespace ReducOp
     inline T sum(const T &a, const T &b);
 }
 
+// covariance matrix kernels, the generic version reduces tensor products
+// over the samples, the version for column vectors centres the samples and
+// computes a single matrix product (symmetric rank-k update for a variance
+// matrix); the sum of the centred products is multiplied by norm
+template <typename T, Index os>
+T covarianceMatrixKernel(const StatArray<T, os> &a, const StatArray<T, os> &b,
+                         const Index pos, const Index n, const double norm);
+template <Index os>
+Mat<double> covarianceMatrixKernel(const StatArray<Mat<double>, os> &a,
+                                   const StatArray<Mat<double>, os> &b,
+                                   const Index pos, const Index n,
+                                   const double norm);
+
 // Sample types
 const int central = -1;
 
@@ -113,6 +157,18 @@ void StatArray<T, os>::resize(const Index size)
     Base::resize(size + os);
 }
 
+template <typename T, Index os>
+Resampling StatArray<T, os>::getResampling(void) const
+{
+    return resampling_;
+}
+
+template <typename T, Index os>
+void StatArray<T, os>::setResampling(const Resampling resampling)
+{
+    resampling_ = resampling;
+}
+
 // operators ///////////////////////////////////////////////////////////////////
 template <typename T, Index os>
 T & StatArray<T, os>::operator[](const Index s)
@@ -168,6 +224,11 @@ T StatArray<T, os>::covariance(const StatArray<T, os> &array, const Index pos,
     T           s1, s2, prs, res = T();
     const Index m = (n >= 0) ? n : size();
     
+    if (array.getResampling() != resampling_)
+    {
+        LATAN_ERROR(Argument, "covariance between arrays with different "
+                    "resampling schemes");
+    }
     if (m)
     {
         auto arraySeg = array.segment(pos+os, m);
@@ -180,29 +241,23 @@ T StatArray<T, os>::covariance(const StatArray<T, os> &array, const Index pos,
         res = prs - ReducOp::prod(s1, s2)/static_cast<double>(m);
     }
     
-    return res/static_cast<double>(m - 1);
+    return res*resamplingNormalisation(resampling_, m);
 }
 
 template <typename T, Index os>
 T StatArray<T, os>::covarianceMatrix(const StatArray<T, os> &array,
                                      const Index pos, const Index n) const
 {
-    T           s1, s2, prs, res = T();
     const Index m = (n >= 0) ? n : size();
-    
-    if (m)
-    {
-        auto arraySeg = array.segment(pos+os, m);
-        auto thisSeg  = this->segment(pos+os, m);
 
-        s1  = thisSeg.redux(&ReducOp::sum<T>);
-        s2  = arraySeg.redux(&ReducOp::sum<T>);
-        prs = thisSeg.binaryExpr(arraySeg, &ReducOp::tensProd<T>)
-                     .redux(&ReducOp::sum<T>);
-        res = prs - ReducOp::tensProd(s1, s2)/static_cast<double>(m);
+    if (array.getResampling() != resampling_)
+    {
+        LATAN_ERROR(Argument, "covariance between arrays with different "
+                    "resampling schemes");
     }
-    
-    return res/static_cast<double>(m - 1);
+
+    return covarianceMatrixKernel(*this, array, pos, m,
+                                  resamplingNormalisation(resampling_, m));
 }
 
 template <typename T, Index os>
@@ -272,6 +327,74 @@ namespace ReducOp
     }
 }
 
+// covariance matrix kernels ///////////////////////////////////////////////////
+template <typename T, Index os>
+T covarianceMatrixKernel(const StatArray<T, os> &a, const StatArray<T, os> &b,
+                         const Index pos, const Index n, const double norm)
+{
+    T s1, s2, prs, res = T();
+
+    if (n)
+    {
+        auto aSeg = a.segment(pos+os, n);
+        auto bSeg = b.segment(pos+os, n);
+
+        s1  = aSeg.redux(&ReducOp::sum<T>);
+        s2  = bSeg.redux(&ReducOp::sum<T>);
+        prs = aSeg.binaryExpr(bSeg, &ReducOp::tensProd<T>)
+                  .redux(&ReducOp::sum<T>);
+        res = prs - ReducOp::tensProd(s1, s2)/static_cast<double>(n);
+    }
+
+    return res*norm;
+}
+
+template <Index os>
+Mat<double> covarianceMatrixKernel(const StatArray<Mat<double>, os> &a,
+                                   const StatArray<Mat<double>, os> &b,
+                                   const Index pos, const Index n,
+                                   const double norm)
+{
+    Mat<double> res;
+
+    if (n)
+    {
+        const Index nRowA = a[pos].rows(), nRowB = b[pos].rows();
+        Mat<double> ca(nRowA, n), cb;
+
+        if ((a[pos].cols() != 1) or (b[pos].cols() != 1))
+        {
+            LATAN_ERROR(Size,
+                        "tensorial product is only valid with column vectors");
+        }
+        for (Index k = 0; k < n; ++k)
+        {
+            ca.col(k) = a[pos + k];
+        }
+        ca.colwise() -= ca.rowwise().mean();
+        if (&a == &b)
+        {
+            res.setZero(nRowA, nRowA);
+            res.selfadjointView<Eigen::Lower>()
+                .rankUpdate(ca, norm);
+            res.triangularView<Eigen::StrictlyUpper>() = res.transpose();
+        }
+        else
+        {
+            cb.resize(nRowB, n);
+            for (Index k = 0; k < n; ++k)
+            {
+                cb.col(k) = b[pos + k];
+            }
+            cb.colwise() -= cb.rowwise().mean();
+            res.noalias() = ca*cb.transpose();
+            res          *= norm;
+        }
+    }
+
+    return res;
+}
+
 // IO type /////////////////////////////////////////////////////////////////////
 template <typename T, Index os>
 IoObject::IoType StatArray<T, os>::getType(void) const
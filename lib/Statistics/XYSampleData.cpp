@@ -177,16 +177,35 @@ const DSample & XYSampleData::y(const Index k, const Index j) const
     return yData_[j].at(k);
 }
 
+// the point samples are looked up once per point, not once per sample
 void XYSampleData::setUnidimData(const DMatSample &xData,
                                  const vector<const DMatSample *> &v)
 {
-    FOR_STAT_ARRAY(xData, s)
+    const Resampling   xResampling = xData.getResampling();
+    vector<Resampling> yResampling;
+
+    for (auto *yData: v)
+    {
+        yResampling.push_back(yData->getResampling());
+    }
     FOR_VEC(xData[central], r)
     {
-        x(r, 0)[s] = xData[s](r);
+        DSample &xr = x(r, 0);
+
+        xr.setResampling(xResampling);
+        FOR_STAT_ARRAY(xData, s)
+        {
+            xr[s] = xData[s](r);
+        }
         for (unsigned int j = 0; j < v.size(); ++j)
         {
-            y(r, j)[s] = (*(v[j]))[s](r);
+            DSample &yrj = y(r, j);
+
+            yrj.setResampling(yResampling[j]);
+            FOR_STAT_ARRAY(xData, s)
+            {
+                yrj[s] = (*(v[j]))[s](r);
+            }
         }
     }
 }
@@ -234,6 +253,41 @@ DVec XYSampleData::getYError(const Index j)
     return data_.getYError(j);
 }
 
+// resampling scheme ///////////////////////////////////////////////////////////
+// samples filled value by value keep the default bootstrap scheme, so they do
+// not conflict with another scheme
+Resampling XYSampleData::getResampling(void) const
+{
+    Resampling res = Resampling::bootstrap;
+    auto       update = [&res](const DSample &sample)
+    {
+        const Resampling r = sample.getResampling();
+
+        if (r != Resampling::bootstrap)
+        {
+            if ((res != Resampling::bootstrap) and (res != r))
+            {
+                LATAN_ERROR(Argument, "data samples with different "
+                            "resampling schemes");
+            }
+            res = r;
+        }
+    };
+
+    for (auto &yj: yData_)
+    for (auto &p: yj)
+    {
+        update(p.second);
+    }
+    for (auto &xi: xData_)
+    for (auto &xr: xi)
+    {
+        update(xr);
+    }
+
+    return res;
+}
+
 // get total fit variance matrix and its pseudo-inverse ////////////////////////
 const DMat & XYSampleData::getFitVarMat(void)
 {
@@ -290,7 +344,9 @@ SampleFitResult XYSampleData::fit(std::vector<Minimizer *> &minimizer,
     DVec            initCopy = init;
     
     result.resize(nSample_);
+    result.setResampling(getResampling());
     result.chi2_.resize(nSample_);
+    result.chi2_.setResampling(result.getResampling());
     result.model_.resize(v.size());
     FOR_STAT_ARRAY(result, s)
     {
@@ -308,7 +364,11 @@ SampleFitResult XYSampleData::fit(std::vector<Minimizer *> &minimizer,
         result.chi2_[s] = sampleResult.getChi2();
         for (unsigned int j = 0; j < v.size(); ++j)
         {
-            result.model_[j].resize(nSample_);
+            if (s == central)
+            {
+                result.model_[j].resize(nSample_);
+                result.model_[j].setResampling(result.getResampling());
+            }
             result.model_[j][s] = sampleResult.getModel(j);
         }
     }
@@ -380,6 +440,8 @@ void XYSampleData::updateXMap(void)
 {
     if (initXMap_)
     {
+        const Resampling resampling = getResampling();
+
         for (Index s = central; s < nSample_; ++s)
         {
             setDataToSample(s);
@@ -388,6 +450,7 @@ void XYSampleData::updateXMap(void)
                 if (s == central)
                 {
                     xMap_[k].resize(nSample_);
+                    xMap_[k].setResampling(resampling);
                 }
                 xMap_[k][s] = data_.x(k);
             }
@@ -432,7 +495,9 @@ void XYSampleData::computeVarMat(void)
         DMatSample z(nSample_, size, 1);
         DMat       var;
         Index      a;
-        
+
+        z.setResampling(getResampling());
+
         FOR_STAT_ARRAY(z, s)
         {
             a = 0;
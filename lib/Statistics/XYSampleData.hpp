@@ -91,6 +91,9 @@ public:
     const DMat &       getXYVar(const Index i, const Index j);
     DVec               getXError(const Index i);
     DVec               getYError(const Index j);
+    // resampling scheme of the data, the samples which are not bootstrap
+    // samples must all have the same scheme
+    Resampling         getResampling(void) const;
     // get total fit variance matrix and its pseudo-inverse
     const DMat & getFitVarMat(void);
     const DMat & getFitVarMatPInv(void);
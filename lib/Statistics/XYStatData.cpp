@@ -270,6 +270,8 @@ FitResult XYStatData::fit(vector<Minimizer *> &minimizer, const DVec &init,
     updateLayout();
     updateFitVarMat();
     updateChi2DataVec();
+    updateMultiPoint(v);
+    updateChi2XMat(getNXDim());
     
     // get number of parameters
     Index nPar      = v[0]->getNPar();
@@ -299,6 +301,42 @@ FitResult XYStatData::fit(vector<Minimizer *> &minimizer, const DVec &init,
     DoubleFunction uncorrChi2(uncorrChi2Func, totalNPar);
     DoubleFunction &chi2 = hasCorrelations() ? corrChi2 : uncorrChi2;
     
+    // exact chi^2 gradient 2 J^T W (m - d), with J the jacobian of the model
+    // values, when all the models have a parameter gradient and all the
+    // x-values are exact (the x-residuals would need the derivatives with
+    // respect to the arguments)
+    bool       hasGrad = (layout.totalXSize == 0);
+    const bool isCorr  = hasCorrelations();
+
+    for (Index jfit = 0; jfit < layout.nYFitDim; ++jfit)
+    {
+        hasGrad = hasGrad and v[layout.yDim[jfit]]->hasParGradientFunction();
+    }
+    if (hasGrad)
+    {
+        auto chi2GradFunc = [this, nPar, nXDim, isCorr, &v](double *g,
+                                                            const double *x)
+        {
+            ConstMap<DVec> p(x, nPar);
+            Map<DVec>      grad(g, nPar);
+
+            updateChi2ModVec(p, v, nPar, nXDim);
+            updateChi2ModJac(p, v, nPar);
+            chi2Vec_ = (chi2ModVec_ - chi2DataVec_);
+            if (isCorr)
+            {
+                grad = 2.*chi2ModJac_*(fitVarInv_*chi2Vec_);
+            }
+            else
+            {
+                grad = 2.*chi2ModJac_
+                       *chi2Vec_.cwiseQuotient(fitVar_.diagonal());
+            }
+        };
+
+        chi2ModJac_.resize(nPar, layout.totalYSize);
+        chi2.setGradientFunction(chi2GradFunc);
+    }
     for (Index p = 0; p < nPar; ++p)
     {
         chi2.varName().setName(p, v[0]->parName().getName(p));
@@ -593,24 +631,127 @@ void XYStatData::updateChi2ModVec(const DVec p,
     updateLayout();
     updateXMap();
     
-    Index a = 0, j, k, ind;
+    Index a = 0, j, ind;
     auto  &par = p.segment(0, nPar), &xsi = p.segment(nPar, layout.totalXSize);
     
+    if (multiFunc_)
+    {
+        // all the outputs at a given point in one call
+        for (auto &pt: multiPoint_)
+        {
+            for (Index i = 0; i < nXDim; ++i)
+            {
+                ind      = layout.xIndFromData[pt.k][i] - layout.totalYSize;
+                xBuf_(i) = (ind >= 0) ? xsi(ind) : xMap_[pt.k](i);
+            }
+            (*multiFunc_)(multiBuf_.data(), xBuf_.data(), par.data());
+            for (auto &c: pt.ind)
+            {
+                chi2ModVec_(c.first) = multiBuf_(c.second);
+            }
+        }
+        a = layout.totalYSize;
+    }
+    else
+    {
+        // each model is evaluated in one call on all its points
+        for (auto &pt: xsiPoint_)
+        {
+            chi2XMat_[pt.jfit](pt.s, pt.i) = xsi(pt.ind);
+        }
+        for (Index jfit = 0; jfit < layout.nYFitDim; ++jfit)
+        {
+            j = layout.yDim[jfit];
+            (*v[j])(chi2ModVec_.data() + a, chi2XMat_[jfit].data(),
+                    par.data(), layout.ySize[jfit]);
+            a += layout.ySize[jfit];
+        }
+    }
+    chi2ModVec_.segment(a, layout.totalXSize) = xsi;
+}
+
+// the x-values of the points of each model are stored in a points x nXDim
+// matrix, the fitted x-values are updated by updateChi2ModVec
+void XYStatData::updateChi2XMat(const Index nXDim)
+{
+    Index k, ind;
+
+    updateLayout();
+    updateXMap();
+    chi2XMat_.resize(layout.nYFitDim);
+    xsiPoint_.clear();
     for (Index jfit = 0; jfit < layout.nYFitDim; ++jfit)
     {
-        j = layout.yDim[jfit];
+        chi2XMat_[jfit].resize(layout.ySize[jfit], nXDim);
         for (Index sfit = 0; sfit < layout.ySize[jfit]; ++sfit)
         {
-            
             k = layout.data[jfit][sfit];
             for (Index i = 0; i < nXDim; ++i)
             {
-                ind      = layout.xIndFromData[k][i] - layout.totalYSize;
-                xBuf_(i) = (ind >= 0) ? xsi(ind) : xMap_[k](i);
+                ind = layout.xIndFromData[k][i] - layout.totalYSize;
+                chi2XMat_[jfit](sfit, i) = xMap_[k](i);
+                if (ind >= 0)
+                {
+                    xsiPoint_.push_back({jfit, sfit, i, ind});
+                }
             }
-            chi2ModVec_(a) = (*v[j])(xBuf_.data(), par.data());
+        }
+    }
+}
+
+void XYStatData::updateChi2ModJac(const DVec p,
+                                  const vector<const DoubleModel *> &v,
+                                  const Index nPar)
+{
+    Index a = 0, j, k;
+    auto  &par = p.segment(0, nPar);
+
+    for (Index jfit = 0; jfit < layout.nYFitDim; ++jfit)
+    {
+        j = layout.yDim[jfit];
+        for (Index sfit = 0; sfit < layout.ySize[jfit]; ++sfit)
+        {
+            k = layout.data[jfit][sfit];
+            v[j]->parGradient(chi2ModJac_.col(a).data(), xMap_[k].data(),
+                              par.data());
             a++;
         }
     }
-    chi2ModVec_.segment(a, layout.totalXSize) = xsi;
+}
+
+void XYStatData::updateMultiPoint(const vector<const DoubleModel *> &v)
+{
+    map<Index, Index> pointInd;
+    Index             a = 0, j, k;
+
+    multiPoint_.clear();
+    multiFunc_.reset();
+    if (layout.nYFitDim < 2)
+    {
+        return;
+    }
+    for (Index jfit = 0; jfit < layout.nYFitDim; ++jfit)
+    {
+        auto &f = v[layout.yDim[jfit]]->getMultiFunction();
+
+        if (!f or (f != v[layout.yDim[0]]->getMultiFunction()))
+        {
+            return;
+        }
+    }
+    for (Index jfit = 0; jfit < layout.nYFitDim; ++jfit)
+    for (Index sfit = 0; sfit < layout.ySize[jfit]; ++sfit)
+    {
+        j = layout.yDim[jfit];
+        k = layout.data[jfit][sfit];
+        if (pointInd.find(k) == pointInd.end())
+        {
+            pointInd[k] = static_cast<Index>(multiPoint_.size());
+            multiPoint_.push_back({k, {}});
+        }
+        multiPoint_[pointInd[k]].ind.push_back({a, v[j]->getMultiOutput()});
+        a++;
+    }
+    multiFunc_ = v[layout.yDim[0]]->getMultiFunction();
+    multiBuf_.resize(v[layout.yDim[0]]->getMultiNOutput());
 }
@@ -124,6 +124,23 @@ private:
     void updateChi2ModVec(const DVec p,
                           const std::vector<const DoubleModel *> &v,
                           const Index nPar, const Index nXDim);
+    void updateChi2ModJac(const DVec p,
+                          const std::vector<const DoubleModel *> &v,
+                          const Index nPar);
+    void updateChi2XMat(const Index nXDim);
+    // buffer the fit points when all the models are outputs of the same
+    // multi-output function, which is then called once per point
+    void updateMultiPoint(const std::vector<const DoubleModel *> &v);
+private:
+    struct MultiPoint
+    {
+        Index                                k;
+        std::vector<std::pair<Index, Index>> ind; // (chi^2 vector, output)
+    };
+    struct XsiPoint
+    {
+        Index jfit, s, i, ind; // x-matrix jfit at (s, i) is xsi(ind)
+    };
 private:
     std::vector<std::map<Index, double>> yData_;
     // no map here for fit performance
@@ -131,8 +148,14 @@ private:
     std::vector<DVec>                    xMap_;
     Mat<DMat>                            xxVar_, yyVar_, xyVar_;
     DMat                                 fitVar_, fitVarInv_;
+    // transposed jacobian of the model part of the chi^2 vector
+    DMat                                 chi2ModJac_;
     DVec                                 chi2DataVec_, chi2ModVec_, chi2Vec_;
-    DVec                                 xBuf_;
+    DVec                                 xBuf_, multiBuf_;
+    std::vector<MultiPoint>              multiPoint_;
+    std::vector<DMat>                    chi2XMat_;
+    std::vector<XsiPoint>                xsiPoint_;
+    std::shared_ptr<DoubleModel::multiFunc> multiFunc_{nullptr};
     bool                                 initXMap_{true};
     bool                                 initChi2DataVec_{true};
 };
@@ -18,6 +18,7 @@
  */
 
 #include <LatAnalyze/Core/OptParser.hpp>
+#include <LatAnalyze/Statistics/BootstrapPlan.hpp>
 #include <LatAnalyze/Statistics/Dataset.hpp>
 #include <LatAnalyze/Io/Io.hpp>
 #include <LatAnalyze/includes.hpp>
@@ -34,12 +35,13 @@ int main(int argc, char *argv[])
 {
     // argument parsing ////////////////////////////////////////////////////////
     OptParser     opt;
-    bool          parsed, dumpBoot;
+    bool          parsed, dumpBoot, counterBoot, jackknife;
     random_device rd;
     SeedType      seed = rd();
     string        manFileName, nameFileName, outDirName;
     string        ext;
     Index         binSize, nSample;
+    unsigned int  nThread = 1;
     
     opt.addOption("n", "nsample"   , OptParser::OptType::value,   true,
                   "number of samples", DEF_NSAMPLE);
@@ -53,6 +55,14 @@ int main(int argc, char *argv[])
                   "output file format", DEF_FMT);
     opt.addOption("d", "dump-boot" , OptParser::OptType::trigger, true,
                   "dump bootstrap sequence");
+    opt.addOption("t", "threads"   , OptParser::OptType::value,   true,
+                  "use the counter-based bootstrap with the given number of "
+                  "threads, the result does not depend on it (default: "
+                  "sequential Mersenne twister bootstrap)");
+    opt.addOption("j", "jackknife" , OptParser::OptType::trigger, true,
+                  "jackknife resampling, the bin size sets the size of the "
+                  "deleted blocks (-n and -r are ignored, incompatible with "
+                  "-t and -d)");
     opt.addOption("" , "help"      , OptParser::OptType::trigger, true,
                   "show this help message and exit");
     parsed = opt.parse(argc, argv);
@@ -73,6 +83,18 @@ int main(int argc, char *argv[])
     ext          = opt.optionValue("f");
     outDirName   = opt.optionValue("o");
     dumpBoot     = opt.gotOption("d");
+    counterBoot  = opt.gotOption("t");
+    jackknife    = opt.gotOption("j");
+    if (jackknife and (counterBoot or dumpBoot))
+    {
+        cerr << "error: the jackknife cannot be used with -t or -d" << endl;
+
+        return EXIT_FAILURE;
+    }
+    if (counterBoot)
+    {
+        nThread = opt.optionValue<unsigned int>("t");
+    }
     manFileName  = opt.getArgs()[0];
     nameFileName = opt.getArgs()[1];
     
@@ -87,7 +109,18 @@ int main(int argc, char *argv[])
     cout << "        #file= " << dataFileName.size() << endl;
     cout << "        #name= " << name.size() << endl;
     cout << "     bin size= " << binSize << endl;
-    cout << "      #sample= " << nSample << endl;
+    if (jackknife)
+    {
+        cout << "   resampling: jackknife" << endl;
+    }
+    else
+    {
+        cout << "      #sample= " << nSample << endl;
+    }
+    if (counterBoot)
+    {
+        cout << "     #threads= " << nThread << endl;
+    }
     cout << "   output dir: " << outDirName << endl;
     cout << "output format: " << ext << endl;
     cout << "------------------------------------------------" << endl;
@@ -113,7 +146,10 @@ int main(int argc, char *argv[])
     cout << endl;
     
     // data resampling /////////////////////////////////////////////////////////
-    DMatSample   s(nSample);
+    // the resampling indices are shared by all the names, the bootstrap is
+    // then done by applying the same weight matrix to each dataset
+    DMatSample    s(nSample);
+    BootstrapPlan plan;
     
     cout << "-- resampling data..." << endl;
     for (unsigned int i = 0; i < name.size(); ++i)
@@ -121,17 +157,39 @@ int main(int argc, char *argv[])
         const string outFileName = name[i] + "_" + manFileName + "." + ext;
         
         cout << '\r' << ProgressBar(i + 1, name.size());
-        data[name[i]].bin(binSize);
-        if ((i == 0) and dumpBoot)
+        if (jackknife)
         {
-            ofstream file(outDirName + "/" + manFileName + ".bootseq");
+            s = data[name[i]].jackknifeMean(binSize);
+        }
+        else
+        {
+            data[name[i]].bin(binSize);
+            if ((i == 0) and dumpBoot)
+            {
+                ofstream file(outDirName + "/" + manFileName + ".bootseq");
+
+                file << "# bootstrap sequences" << endl;
+                file << "# manifest file: " << manFileName << endl;
+                file << "#      bin size: " << binSize << endl;
+                if (counterBoot)
+                {
+                    data[name[i]].dumpParallelBootstrapSeq(file, nSample, seed);
+                }
+                else
+                {
+                    data[name[i]].dumpBootstrapSeq(file, nSample, seed);
+                }
+            }
+            if (i == 0)
+            {
+                const auto gen = counterBoot
+                                 ? BootstrapPlan::Generator::counter
+                                 : BootstrapPlan::Generator::mersenneTwister;
 
-            file << "# bootstrap sequences" << endl;
-            file << "# manifest file: " << manFileName << endl;
-            file << "#      bin size: " << binSize << endl;
-            data[name[i]].dumpBootstrapSeq(file, nSample, seed);
+                plan = BootstrapPlan(nSample, data[name[i]].size(), seed, gen);
+            }
+            s = plan(data[name[i]], nThread);
         }
-        s = data[name[i]].bootstrapMean(nSample, seed);
         Io::save<DMatSample>(s, outDirName + "/" + outFileName,
                              File::Mode::write, outFileName);
     }